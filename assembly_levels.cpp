@@ -0,0 +1,244 @@
+#include "assembly_levels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+// --- LEVEL LIST ---
+
+bool parse_assembly_levels(const std::string& text, std::vector<AssemblyLevel>& levels) {
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const size_t sep = item.find(':');
+        if (sep == std::string::npos) return false;
+        AssemblyLevel level;
+        try {
+            size_t used_len = 0, used_join = 0;
+            level.max_len = std::stoll(item.substr(0, sep), &used_len);
+            level.join = std::stod(item.substr(sep + 1), &used_join);
+            if (used_len != sep || used_join != item.size() - sep - 1) return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (level.max_len < 1 || (!levels.empty() && level.max_len <= levels.back().max_len)) return false;
+        levels.push_back(level);
+    }
+    return !levels.empty();
+}
+
+// --- LEVEL DP ---
+
+namespace {
+
+// Units of one level over the leaf cuts: the unit [cuts[m], cuts[k]) for
+// every k up to end[m], its cost (leaf join at m included, as in prefix) and
+// the start of its last unit of the level below (m when it is just one).
+struct LevelUnits {
+    std::vector<size_t> end;
+    std::vector<std::vector<double>> cost;   // cost[m][k - m - 1]
+    std::vector<std::vector<std::uint32_t>> last;
+};
+
+class LevelSolver {
+public:
+    LevelSolver(const std::vector<std::uint64_t>& cuts, const std::vector<double>& prefix, double leaf_join,
+                const std::vector<AssemblyLevel>& levels)
+        : cuts_(cuts), P_(prefix), leaf_join_(leaf_join), levels_(levels), units_(levels.size() + 1) {
+        for (const AssemblyLevel& level : levels) monotone_ = monotone_ && level.join >= leaf_join;
+        tolerance_ = 1e-9 * std::max(1.0, std::fabs(prefix.back()));
+    }
+
+    double solve(std::vector<std::uint8_t>& cut_level) {
+        const size_t n = cuts_.size() - 1;
+        const size_t L = levels_.size();
+        for (size_t l = 2; l <= L; ++l) {
+            LevelUnits& u = units_[l];
+            const std::uint64_t max_len = static_cast<std::uint64_t>(levels_[l - 1].max_len);
+            u.end.resize(n);
+            u.cost.resize(n);
+            u.last.resize(n);
+            std::vector<double> R;
+            std::vector<std::uint32_t> from;
+            for (size_t m = 0, k = 0; m < n; ++m) {
+                k = std::max(k, m);
+                while (k < n && cuts_[k + 1] - cuts_[m] <= max_len) ++k;
+                u.end[m] = std::max(k, m + 1);
+                row(m, u.end[m], l - 1, R, from);
+                u.cost[m].assign(R.begin() + 1, R.end());
+                u.last[m].assign(from.begin() + 1, from.end());
+            }
+            // The level below is only needed for its last units now.
+            if (l > 2) std::vector<std::vector<double>>().swap(units_[l - 1].cost);
+        }
+        std::vector<double> R;
+        std::vector<std::uint32_t> from;
+        row(0, n, L, R, from);
+        for (size_t k = n; k > 0;) {
+            const size_t m = from[k];
+            if (m > 0) cut_level[m] = static_cast<std::uint8_t>(L);
+            mark(L, m, k, cut_level);
+            k = m;
+        }
+        return P_[0] + R[n];
+    }
+
+private:
+    // Cheapest [cuts[m], cuts[k]) as consecutive units of level s, for k in
+    // (m, end]: R[k - m], with from[k - m] the start of the last unit.  Each
+    // junction between them pays levels[s - 1].join instead of the leaf join;
+    // R[0] offsets the unit starting at m, whose junction is not theirs.
+    //
+    // A unit [p, k) costs P[k] - P[p] plus the joins above the leaf join
+    // inside it, X(p, k), so the candidates are key(p) = R[p] - P[p] plus
+    // X(p, k).  A first-level unit has no such joins: the best p is the
+    // sliding-window minimum of key.  Above it, while no level join is below
+    // the leaf join, X(p, k) only falls as p moves right (the unit [p', k)
+    // inside [p, k) needs no more joins), so a start with a key no lower than
+    // a later one's never wins, and the window keeps one start per key
+    // (to rounding): a handful of join counts instead of every cut.
+    void row(size_t m, size_t end, size_t s, std::vector<double>& R, std::vector<std::uint32_t>& from) const {
+        const double delta = levels_[s - 1].join - leaf_join_;
+        const std::uint64_t max_len = static_cast<std::uint64_t>(levels_[0].max_len);
+        const LevelUnits& u = units_[s];
+        R.assign(end - m + 1, std::numeric_limits<double>::infinity());
+        from.assign(end - m + 1, static_cast<std::uint32_t>(m));
+        R[0] = -delta;
+        auto key = [&](size_t p) { return R[p - m] - P_[p]; };
+        auto fits = [&](size_t p, size_t k) { return s == 1 ? cuts_[k] - cuts_[p] <= max_len : u.end[p] >= k; };
+        const bool prune = s == 1 || monotone_;
+        std::deque<size_t> window;   // starts, keys increasing front to back when pruned
+        for (size_t k = m + 1; k <= end; ++k) {
+            const size_t q = k - 1;
+            while (prune && !window.empty() && !(key(window.back()) < key(q) - tolerance_)) window.pop_back();
+            window.push_back(q);
+            while (window.front() < q && !fits(window.front(), k)) window.pop_front();
+            if (s == 1) {
+                from[k - m] = static_cast<std::uint32_t>(window.front());
+                R[k - m] = key(window.front()) + delta + P_[k];
+                continue;
+            }
+            // Larger p first, so ties keep it.
+            for (auto it = window.rbegin(); it != window.rend(); ++it) {
+                const size_t p = *it;
+                const double c = R[p - m] + delta + u.cost[p][k - p - 1];
+                if (c < R[k - m]) {
+                    R[k - m] = c;
+                    from[k - m] = static_cast<std::uint32_t>(p);
+                }
+            }
+        }
+    }
+
+    // Sets the levels of the junctions inside the level-l unit [m, k).
+    void mark(size_t l, size_t m, size_t k, std::vector<std::uint8_t>& cut_level) const {
+        if (l < 2) return;
+        const LevelUnits& u = units_[l];
+        for (;;) {
+            const size_t p = u.last[m][k - m - 1];
+            if (p == m) {
+                mark(l - 1, m, k, cut_level);
+                return;
+            }
+            cut_level[p] = static_cast<std::uint8_t>(l - 1);
+            mark(l - 1, p, k, cut_level);
+            k = p;
+        }
+    }
+
+    const std::vector<std::uint64_t>& cuts_;
+    const std::vector<double>& P_;
+    double leaf_join_;
+    const std::vector<AssemblyLevel>& levels_;
+    std::vector<LevelUnits> units_;   // by level, from 2
+    bool monotone_ = true;            // no level join below the leaf join
+    double tolerance_ = 0.0;          // rounding of key differences
+};
+
+// Entries LevelSolver would table: for every level above the first and every
+// start, the cuts within one unit of it.  Counting stops past cap.
+std::uint64_t unit_entries(const std::vector<std::uint64_t>& cuts, const std::vector<AssemblyLevel>& levels,
+                           std::uint64_t cap) {
+    const size_t n = cuts.size() - 1;
+    std::uint64_t total = 0;
+    for (size_t l = 1; l < levels.size(); ++l) {
+        const std::uint64_t max_len = static_cast<std::uint64_t>(levels[l].max_len);
+        for (size_t m = 0, k = 0; m < n; ++m) {
+            k = std::max(k, m);
+            while (k < n && cuts[k + 1] - cuts[m] <= max_len) ++k;
+            total += std::max(k, m + 1) - m;
+            if (total > cap) return total;
+        }
+    }
+    return total;
+}
+
+// Solves each level on its own as a sliding-window minimum over the cuts
+// kept by the level below, priced from that level's prefix costs: O(#blocks)
+// per level, but the partition of one level is fixed before the next is seen.
+double assemble_per_level(const std::vector<std::uint64_t>& cuts, const std::vector<double>& prefix, double leaf_join,
+                          const std::vector<AssemblyLevel>& levels, std::vector<std::uint8_t>& cut_level) {
+    // The cuts kept by the level below (indexes into cuts) and its prefix costs.
+    std::vector<size_t> kept(cuts.size());
+    for (size_t k = 0; k < kept.size(); ++k) kept[k] = k;
+    std::vector<double> P = prefix;
+    double lower_join = leaf_join;
+
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const size_t n = kept.size();
+        const double join = levels[l].join;
+        const std::uint64_t max_len = static_cast<std::uint64_t>(levels[l].max_len);
+        // D[k] = P[k] + min over the window of key(m); a unit from m > 0 pays
+        // this level's join instead of the lower one.
+        std::vector<double> D(n, 0.0);
+        std::vector<size_t> from(n, 0);
+        auto key = [&](size_t m) { return D[m] - P[m] + (m > 0 ? join - lower_join : 0.0); };
+        std::deque<size_t> window;   // keys increasing front to back; ties keep the larger m
+        size_t lo = 0;
+        for (size_t k = 1; k < n; ++k) {
+            const size_t m = k - 1;
+            while (!window.empty() && !(key(window.back()) < key(m))) window.pop_back();
+            window.push_back(m);
+            while (lo < k - 1 && cuts[kept[k]] - cuts[kept[lo]] > max_len) ++lo;
+            while (window.front() < lo) window.pop_front();
+            from[k] = window.front();
+            D[k] = P[k] + key(from[k]);
+        }
+
+        std::vector<size_t> path;
+        for (size_t k = n - 1; k > 0; k = from[k]) path.push_back(k);
+        path.push_back(0);
+        std::reverse(path.begin(), path.end());
+        std::vector<size_t> next_kept(path.size());
+        std::vector<double> next_P(path.size());
+        for (size_t t = 0; t < path.size(); ++t) {
+            next_kept[t] = kept[path[t]];
+            next_P[t] = D[path[t]];
+            if (t > 0 && t + 1 < path.size()) cut_level[next_kept[t]] = static_cast<std::uint8_t>(l + 1);
+        }
+        kept.swap(next_kept);
+        P.swap(next_P);
+        lower_join = join;
+    }
+    return P.back();
+}
+
+} // namespace
+
+double assemble_levels(const std::vector<std::uint64_t>& cuts, const std::vector<double>& prefix, double leaf_join,
+                       const std::vector<AssemblyLevel>& levels, std::vector<std::uint8_t>& cut_level,
+                       std::uint64_t max_units) {
+    cut_level.assign(cuts.size(), 0);
+    if (cuts.size() < 2) return 0.0;
+    const std::uint64_t entries = unit_entries(cuts, levels, max_units);
+    if (entries > max_units) {
+        std::cerr << "WARNING: --levels would table over " << max_units << " units for " << cuts.size() - 1
+                  << " blocks; solving one level at a time instead (not exact across levels)" << std::endl;
+        return assemble_per_level(cuts, prefix, leaf_join, levels, cut_level);
+    }
+    LevelSolver solver(cuts, prefix, leaf_join, levels);
+    return solver.solve(cut_level);
+}
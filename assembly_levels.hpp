@@ -0,0 +1,43 @@
+#pragma once
+// Hierarchical assembly above the block level.
+//
+// Blocks are assembled into intermediates of at most levels[0].max_len bp,
+// those into larger units of at most levels[1].max_len bp, and so on; every
+// junction between two units of level k costs levels[k].join instead of the
+// join of the level below.  Units start and end at the leaf plan's cuts, and
+// all levels are solved together: the cost of a unit [a, b) of level k is a
+// DP over the units of level k - 1 between a and b (for the first level the
+// leaf plan's P[b] - P[a]), and the record a DP over top-level units, which
+// is exact for the given blocks.  One level is a sliding-window minimum over
+// the cuts, O(#blocks); each further level tables its units, O(#blocks x
+// cuts per unit) time and memory while no level join is below the leaf join
+// (see LevelSolver::row), times the cuts per unit of the level below if one
+// is.  Dense cuts (1-bp blocks from the greedy planners) under long upper
+// levels would need far too many entries, so past a cap (kMaxAssemblyUnits)
+// the levels are solved one at a time instead, each a sliding-window minimum
+// over the cuts kept by the level below: O(#blocks) per level, but no longer
+// exact across levels.  A warning says so.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AssemblyLevel {
+    long long max_len = 0;   // longest unit, bp
+    double join = 0.0;       // cost per junction between two units
+};
+
+// Parses "LEN:JOIN[,LEN:JOIN...]" with LEN increasing.
+bool parse_assembly_levels(const std::string& text, std::vector<AssemblyLevel>& levels);
+
+// cuts[0] = 0 < cuts[1] < ... < cuts.back() = N are the leaf block boundaries
+// and prefix[k] the leaf plan cost of [0, cuts[k]), leaf joins included.
+// Every leaf block must fit the first level.  Returns the hierarchical cost
+// and sets cut_level[k] to the highest level joined at cuts[k]: 0 for a plain
+// block junction, k + 1 for a junction of levels[k] units.  Past max_units
+// tabled units (12 bytes each) the levels are solved one at a time.
+constexpr std::uint64_t kMaxAssemblyUnits = std::uint64_t(1) << 25;
+double assemble_levels(const std::vector<std::uint64_t>& cuts, const std::vector<double>& prefix, double leaf_join,
+                       const std::vector<AssemblyLevel>& levels, std::vector<std::uint8_t>& cut_level,
+                       std::uint64_t max_units = kMaxAssemblyUnits);
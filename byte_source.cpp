@@ -0,0 +1,296 @@
+#include "byte_source.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+// --- PLAIN ---
+
+class PlainSource : public ByteSource {
+public:
+    explicit PlainSource(const std::string& path) : in_(path, std::ios::binary) {}
+    bool is_open() const { return in_.is_open(); }
+    size_t read(char* buf, size_t n) override {
+        in_.read(buf, static_cast<std::streamsize>(n));
+        return static_cast<size_t>(in_.gcount());
+    }
+    bool failed() const override { return in_.bad(); }
+    const char* kind() const override { return "plain"; }
+
+private:
+    std::ifstream in_;
+};
+
+// --- GZIP ---
+
+class GzipSource : public ByteSource {
+public:
+    explicit GzipSource(const std::string& path) : gz_(gzopen(path.c_str(), "rb")) {
+        if (gz_) gzbuffer(gz_, 1 << 18);
+    }
+    ~GzipSource() override { if (gz_) gzclose(gz_); }
+    bool is_open() const { return gz_ != nullptr; }
+    size_t read(char* buf, size_t n) override {
+        if (failed_) return 0;
+        const int got = gzread(gz_, buf, static_cast<unsigned>(std::min<size_t>(n, 1u << 30)));
+        if (got < 0) {
+            int errnum = 0;
+            std::cerr << "ERROR: gzip decompression failed: " << gzerror(gz_, &errnum) << std::endl;
+            failed_ = true;
+            return 0;
+        }
+        return static_cast<size_t>(got);
+    }
+    bool failed() const override { return failed_; }
+    const char* kind() const override { return "gzip"; }
+
+private:
+    gzFile gz_;
+    bool failed_ = false;
+};
+
+// --- BGZF ---
+
+// BGZF is a series of independent gzip members of at most 64 KiB, each
+// carrying its compressed size in a 'BC' extra subfield.  One I/O thread cuts
+// the file into batches of whole blocks, workers inflate batches in parallel,
+// and read() hands the output back in file order.
+class BgzfSource : public ByteSource {
+public:
+    BgzfSource(const std::string& path, int threads) : in_(path, std::ios::binary) {
+        if (!in_.is_open()) return;
+        const int workers = std::max(1, threads);
+        max_in_flight_ = static_cast<size_t>(2 * workers);
+        io_thread_ = std::thread([this] { read_batches(); });
+        for (int t = 0; t < workers; ++t) workers_.emplace_back([this] { inflate_batches(); });
+    }
+    ~BgzfSource() override {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (io_thread_.joinable()) io_thread_.join();
+        for (auto& w : workers_) w.join();
+    }
+    bool is_open() const { return in_.is_open(); }
+
+    size_t read(char* buf, size_t n) override {
+        size_t done = 0;
+        while (done < n) {
+            if (cur_pos_ == cur_.size()) {
+                if (!next_batch()) break;
+                continue;
+            }
+            const size_t take = std::min(n - done, cur_.size() - cur_pos_);
+            std::memcpy(buf + done, cur_.data() + cur_pos_, take);
+            cur_pos_ += take;
+            done += take;
+        }
+        return done;
+    }
+    bool failed() const override {
+        std::lock_guard<std::mutex> lock(mu_);
+        return failed_;
+    }
+    const char* kind() const override { return "bgzf"; }
+
+private:
+    struct Batch {
+        std::vector<unsigned char> comp;
+        std::vector<size_t> block_ends;    // end offset of each block in comp
+        std::vector<char> out;
+    };
+
+    static constexpr size_t kBlocksPerBatch = 64;   // ~4 MiB of output
+    static constexpr std::uint32_t kMaxBlockOutput = 1u << 16;   // BGZF limit per block
+
+    // Reads one whole BGZF block and appends it to batch.comp.  Returns false at
+    // a clean end of file; sets failed_ on a malformed block.
+    bool read_block(Batch& batch) {
+        unsigned char hdr[12];
+        in_.read(reinterpret_cast<char*>(hdr), sizeof(hdr));
+        if (in_.gcount() == 0) return false;
+        const std::uint16_t xlen = static_cast<std::uint16_t>(hdr[10] | (hdr[11] << 8));
+        std::vector<unsigned char> extra(xlen);
+        if (in_.gcount() != sizeof(hdr) || hdr[0] != 0x1f || hdr[1] != 0x8b || !(hdr[3] & 4) ||
+            !in_.read(reinterpret_cast<char*>(extra.data()), xlen)) {
+            return fail("truncated or non-BGZF block header");
+        }
+        long bsize = -1;
+        for (size_t p = 0; p + 4 <= extra.size();) {
+            const std::uint16_t slen = static_cast<std::uint16_t>(extra[p + 2] | (extra[p + 3] << 8));
+            if (extra[p] == 'B' && extra[p + 1] == 'C' && slen == 2 && p + 6 <= extra.size()) {
+                bsize = extra[p + 4] | (extra[p + 5] << 8);
+            }
+            p += 4 + slen;
+        }
+        const long rest = bsize + 1 - static_cast<long>(sizeof(hdr)) - xlen;
+        if (bsize < 0 || rest < 8) return fail("BGZF block without a valid BC subfield");
+
+        const size_t base = batch.comp.size();
+        batch.comp.resize(base + sizeof(hdr) + xlen + static_cast<size_t>(rest));
+        std::memcpy(&batch.comp[base], hdr, sizeof(hdr));
+        std::memcpy(&batch.comp[base + sizeof(hdr)], extra.data(), xlen);
+        if (!in_.read(reinterpret_cast<char*>(&batch.comp[base + sizeof(hdr) + xlen]), rest)) {
+            return fail("truncated BGZF block");
+        }
+        batch.block_ends.push_back(batch.comp.size());
+        return true;
+    }
+
+    bool fail(const char* what) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!failed_) std::cerr << "ERROR: BGZF decompression failed: " << what << std::endl;
+        failed_ = true;
+        return false;
+    }
+
+    void read_batches() {
+        for (std::uint64_t seq = 0;; ++seq) {
+            Batch batch;
+            while (batch.block_ends.size() < kBlocksPerBatch && read_block(batch)) {}
+            std::unique_lock<std::mutex> lock(mu_);
+            if (batch.block_ends.empty() || failed_) {
+                total_batches_ = seq;
+                input_done_ = true;
+                cv_.notify_all();
+                return;
+            }
+            cv_.wait(lock, [this, seq] { return stopping_ || seq - next_seq_ < max_in_flight_; });
+            if (stopping_) return;
+            pending_.emplace_back(seq, std::move(batch));
+            cv_.notify_all();
+        }
+    }
+
+    void inflate_batches() {
+        z_stream zs{};
+        inflateInit2(&zs, -15);
+        for (;;) {
+            std::pair<std::uint64_t, Batch> job;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return stopping_ || !pending_.empty() || input_done_; });
+                if (stopping_ || pending_.empty()) break;
+                job = std::move(pending_.front());
+                pending_.pop_front();
+            }
+            const bool ok = inflate_batch(zs, job.second);
+            std::lock_guard<std::mutex> lock(mu_);
+            if (!ok && !failed_) {
+                std::cerr << "ERROR: BGZF decompression failed: corrupt block data" << std::endl;
+                failed_ = true;
+            }
+            job.second.comp.clear();
+            job.second.comp.shrink_to_fit();
+            ready_.emplace(job.first, std::move(job.second));
+            cv_.notify_all();
+        }
+        inflateEnd(&zs);
+    }
+
+    static bool inflate_batch(z_stream& zs, Batch& batch) {
+        size_t begin = 0;
+        for (const size_t end : batch.block_ends) {
+            const unsigned char* block = &batch.comp[begin];
+            const size_t xlen = static_cast<size_t>(block[10] | (block[11] << 8));
+            const size_t data_off = 12 + xlen;
+            const size_t block_size = end - begin;
+            const unsigned char* trailer = block + block_size - 8;
+            const std::uint32_t crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<std::uint32_t>(trailer[3]) << 24);
+            const std::uint32_t isize = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) | (static_cast<std::uint32_t>(trailer[7]) << 24);
+
+            if (isize > kMaxBlockOutput) return false;
+
+            // An empty block (the standard EOF marker) may start a batch, so
+            // out can still be unallocated; zlib rejects a null next_out.
+            unsigned char empty_out = 0;
+            const size_t out_base = batch.out.size();
+            batch.out.resize(out_base + isize);
+            inflateReset(&zs);
+            zs.next_in = const_cast<unsigned char*>(block + data_off);
+            zs.avail_in = static_cast<unsigned>(block_size - data_off - 8);
+            zs.next_out = isize ? reinterpret_cast<unsigned char*>(batch.out.data() + out_base) : &empty_out;
+            zs.avail_out = isize;
+            const int rc = inflate(&zs, Z_FINISH);
+            if (rc != Z_STREAM_END || zs.avail_out != 0) return false;
+            const uLong got_crc = isize ? crc32(0L, reinterpret_cast<const Bytef*>(batch.out.data() + out_base), isize) : 0;
+            if (got_crc != crc) return false;
+            begin = end;
+        }
+        return true;
+    }
+
+    bool next_batch() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] {
+            return failed_ || ready_.count(next_seq_) || (input_done_ && next_seq_ >= total_batches_);
+        });
+        if (failed_) return false;
+        auto it = ready_.find(next_seq_);
+        if (it == ready_.end()) return false;
+        cur_ = std::move(it->second.out);
+        cur_pos_ = 0;
+        ready_.erase(it);
+        ++next_seq_;
+        cv_.notify_all();
+        return true;
+    }
+
+    std::ifstream in_;
+    std::thread io_thread_;
+    std::vector<std::thread> workers_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::pair<std::uint64_t, Batch>> pending_;
+    std::map<std::uint64_t, Batch> ready_;
+    std::uint64_t next_seq_ = 0;
+    std::uint64_t total_batches_ = 0;
+    size_t max_in_flight_ = 2;
+    bool input_done_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+
+    std::vector<char> cur_;
+    size_t cur_pos_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<ByteSource> open_byte_source(const std::string& path, int threads) {
+    unsigned char magic[16] = {0};
+    size_t got = 0;
+    {
+        std::ifstream probe(path, std::ios::binary);
+        if (!probe.is_open()) return nullptr;
+        probe.read(reinterpret_cast<char*>(magic), sizeof(magic));
+        got = static_cast<size_t>(probe.gcount());
+    }
+    const bool gzip = got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+    const bool bgzf = gzip && got >= 16 && (magic[3] & 4) && magic[12] == 'B' && magic[13] == 'C';
+
+    if (bgzf) {
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        auto src = std::make_unique<BgzfSource>(path, threads);
+        if (src->is_open()) return src;
+    } else if (gzip) {
+        auto src = std::make_unique<GzipSource>(path);
+        if (src->is_open()) return src;
+    } else {
+        auto src = std::make_unique<PlainSource>(path);
+        if (src->is_open()) return src;
+    }
+    return nullptr;
+}
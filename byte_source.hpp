@@ -0,0 +1,26 @@
+#pragma once
+// Raw byte input behind FastaReader: plain files, gzip, and BGZF with
+// multithreaded block decompression.
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+    // Reads up to n bytes into buf.  Returns 0 at end of input or on error.
+    virtual size_t read(char* buf, size_t n) = 0;
+    // True once a read stopped early because the input was corrupt or unreadable.
+    virtual bool failed() const = 0;
+    // "plain", "gzip" or "bgzf".
+    virtual const char* kind() const = 0;
+};
+
+// Opens path and picks the decoder from its magic bytes:
+//   - BGZF (gzip with a 'BC' extra subfield, as written by bgzip): blocks are
+//     inflated by `threads` workers (0 = hardware concurrency) ahead of the reader;
+//   - any other gzip stream (including concatenated members): zlib, one thread;
+//   - anything else is read as plain text.
+// Returns nullptr when the file cannot be opened.
+std::unique_ptr<ByteSource> open_byte_source(const std::string& path, int threads = 0);
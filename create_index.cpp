@@ -1,37 +1,95 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
 #include <sdsl/csa_wt.hpp>
 #include <sdsl/construct.hpp>
 #include <sdsl/util.hpp> // Required for register_tmp_file
+#include "donor_colors.hpp"
+#include "fasta_reader.hpp"
+#include "r_index.hpp"
 
 using namespace sdsl;
 using fm_index_t = csa_wt<wt_huff<bit_vector_il<256>>, 512, 1024>;
 
 int main(int argc, char* argv[]) {
     if (argc == 2 && std::string(argv[1]) == "--help") {
-        std::cout << "Usage: " << argv[0] << " <input.fasta> <output.fm>\n\n"
+        std::cout << "Usage: " << argv[0] << " [--circular L] [--r-index] <input.fasta> <output.fm>\n\n"
                   << "Build an FM-index (SDSL csa_wt) over the nucleotide sequence(s)\n"
                   << "contained in a FASTA file and serialise it to a binary .fm file.\n\n"
                   << "Arguments:\n"
-                  << "  input.fasta   Path to the source genome FASTA (single or multi-record).\n"
-                  << "                Non-ACGT characters are stripped before indexing.\n"
+                  << "  input.fasta   Path to the source genome FASTA (single or multi-record;\n"
+                  << "                plain, gzip or BGZF-compressed).\n"
+                  << "                Non-ACGT characters are stripped before indexing; records\n"
+                  << "                are separated by a newline so no block spans two records.\n"
+                  << "                A comma-separated list of FASTA files (a donor panel, one\n"
+                  << "                donor per file) builds one generalized index over all of\n"
+                  << "                them and writes the donor of every suffix to\n"
+                  << "                output.fm.colors; the planners load it with the index and\n"
+                  << "                take one --source-pcr price per donor.\n"
                   << "  output.fm     Destination path for the serialised FM-index.\n\n"
+                  << "Options:\n"
+                  << "  --circular L  The source records are circular: each is indexed with its\n"
+                  << "                first L - 1 bases appended, so every block of up to L bp\n"
+                  << "                that runs across the origin can be reused.  Use the\n"
+                  << "                planners' W for L.  A block lying within those first\n"
+                  << "                bases is then counted twice by --multi-penalty and\n"
+                  << "                --unique-only.\n"
+                  << "  --r-index     Store a run-length compressed BWT (r-index) instead of the\n"
+                  << "                csa_wt.  Its size grows with the number of BWT runs rather\n"
+                  << "                than the text length, so a collection of closely related\n"
+                  << "                genomes (e.g. many strains of one species) takes a fraction\n"
+                  << "                of the space.  The planners detect the format on load; plans\n"
+                  << "                are identical.  Construction still builds the suffix array\n"
+                  << "                in memory.  A panel's .colors file is not compressed: it\n"
+                  << "                holds ceil(log2 D) bits per base for D donors, and\n"
+                  << "                --source-pcr adds about 2 bits per base, so with colours\n"
+                  << "                the memory stays linear in the panel's length.\n\n"
                   << "Environment variables:\n"
                   << "  SDSL_CACHE_DIR   Directory for SDSL temporary construction files\n"
                   << "                   (defaults to SLURM_TMPDIR, then '.' if unset).\n\n"
                   << "Example:\n"
                   << "  ./create_index source.fasta source.fm\n"
+                  << "  ./create_index strainA.fa,strainB.fa,strainC.fa panel.fm\n"
+                  << "  ./create_index --r-index ecoli_strains.fa ecoli_strains.fm\n"
                   << std::endl;
         return 0;
     }
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <input.fasta> <output.fm>  (use --help for details)" << std::endl;
+    int a = 1;
+    long long wrap = 0;   // bases of each record appended to its end
+    bool r_index = false;
+    while (argc - a > 2) {
+        const std::string opt = argv[a];
+        if (opt == "--circular") {
+            long long L = 0;
+            try {
+                L = std::stoll(argv[a + 1]);
+            } catch (const std::exception&) {
+                L = 0;
+            }
+            if (L < 1) {
+                std::cerr << "Error: --circular expects a block length of at least 1" << std::endl;
+                return 1;
+            }
+            wrap = L - 1;
+            a += 2;
+        } else if (opt == "--r-index") {
+            r_index = true;
+            ++a;
+        } else {
+            break;
+        }
+    }
+    if (argc - a != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--circular L] [--r-index] <input.fasta> <output.fm>  (use --help for details)" << std::endl;
         return 1;
     }
-    std::string input_file = argv[1];
-    std::string output_file = argv[2];
+    std::string input_file = argv[a];
+    std::string output_file = argv[a + 1];
 
     const char* cache_dir_env = std::getenv("SDSL_CACHE_DIR");
     if (cache_dir_env == nullptr || std::string(cache_dir_env).empty()) {
@@ -46,12 +104,91 @@ int main(int argc, char* argv[]) {
         cache_dir = ".";
     }
 
+    // Clean the FASTA with the planners' reader into a plain text file that
+    // SDSL constructs from: ACGT only, one line per record (circular ones
+    // followed by their first wrap bases).
+    // A donor panel: one donor per input file, starting at donor_start in the text.
+    std::vector<std::string> inputs;
+    {
+        std::stringstream ss(input_file);
+        std::string path;
+        while (std::getline(ss, path, ',')) inputs.push_back(path);
+    }
+    const bool panel = inputs.size() > 1;
+    std::vector<std::string> donor_names;
+    std::vector<std::uint64_t> donor_start;
+    const std::string text_file = (std::filesystem::path(cache_dir) / (util::basename(output_file) + ".clean.txt")).string();
+    {
+        std::ofstream text(text_file, std::ios::binary);
+        if (!text.is_open()) {
+            std::cerr << "Error: Could not write " << text_file << std::endl;
+            return 1;
+        }
+        std::uint64_t written = 0;
+        for (const std::string& input : inputs) {
+            FastaReader reader(input);
+            if (!reader.is_open()) {
+                std::cerr << "Error: Could not open " << input << std::endl;
+                std::filesystem::remove(text_file);
+                return 1;
+            }
+            donor_names.push_back(std::filesystem::path(input).stem().string());
+            donor_start.push_back(written);
+            FastaRecord rec;
+            while (reader.next(rec)) {
+                if (rec.seq.empty()) continue;
+                text.write(rec.seq.data(), static_cast<std::streamsize>(rec.seq.size()));
+                // A substring of the circle is at most N bases, so at most N - 1 wrap.
+                const long long tail = std::min<long long>(wrap, static_cast<long long>(rec.seq.size()) - 1);
+                text.write(rec.seq.data(), static_cast<std::streamsize>(tail));
+                text.put('\n');
+                written += rec.seq.size() + static_cast<std::uint64_t>(tail) + 1;
+            }
+            if (reader.failed() || !text) {
+                std::cerr << "Error: Could not prepare text for " << input << std::endl;
+                std::filesystem::remove(text_file);
+                return 1;
+            }
+        }
+    }
+
     cache_config config(false, cache_dir, util::basename(output_file));
     fm_index_t index;
-    construct(index, input_file, config, 1); 
+    construct(index, text_file, config, 1);
+    std::filesystem::remove(text_file);
+
+    // The donor of every suffix, read off the suffix array SDSL left in the
+    // cache while building the index.
+    const std::string colors_file = donor_colors_path(output_file);
+    std::filesystem::remove(colors_file);
+    if (panel) {
+        int_vector_buffer<> sa(cache_file_name(conf::KEY_SA, config));
+        int_vector<> color(sa.size(), 0, static_cast<uint8_t>(bits::hi(donor_names.size() - 1) + 1));
+        for (std::uint64_t k = 0; k < sa.size(); ++k) {
+            const std::uint64_t pos = sa[k];
+            color[k] = static_cast<std::uint64_t>(std::upper_bound(donor_start.begin(), donor_start.end(), pos) - donor_start.begin() - 1);
+        }
+        if (!store_donor_colors(colors_file, donor_names, color)) {
+            std::cerr << "Error: Could not write donor colours to " << colors_file << std::endl;
+            util::delete_all_files(config.file_map);
+            return 1;
+        }
+    }
     
-    if (store_to_file(index, output_file)) {
-        std::cout << "✅ Successfully created index '" << output_file << "' from '" << input_file << "'" << std::endl;
+    // The r-index is built from the BWT the csa_wt was built from, so both
+    // have the same suffix array order (and donor colours).
+    RIndex runs;
+    if (r_index) {
+        int_vector_buffer<8> bwt(cache_file_name(conf::KEY_BWT, config));
+        runs.build(bwt);
+        util::clear(index);
+    }
+    if (r_index ? runs.store(output_file) : store_to_file(index, output_file)) {
+        std::cout << "✅ Successfully created " << (r_index ? "r-index" : "index") << " '" << output_file << "' from '"
+                  << input_file << "'";
+        if (panel) std::cout << " (" << donor_names.size() << " donors)";
+        if (r_index) std::cout << " (" << runs.runs() << " BWT runs over " << runs.size() << " positions)";
+        std::cout << std::endl;
         
         // --- CORRECTED FUNCTION NAME ---
         util::delete_all_files(config.file_map); // Changed from delete_files
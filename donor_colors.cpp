@@ -0,0 +1,64 @@
+#include "donor_colors.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// --- PRICE TIERS ---
+
+DonorTiers::DonorTiers(const DonorColors& colors, std::vector<std::uint16_t> tier_of)
+    : colors_(colors), tier_of_(std::move(tier_of)) {
+    // The tiers are only needed to build the structure, which answers
+    // positions on its own; they take ceil(log2 T) bits each meanwhile.
+    const std::uint16_t top = *std::max_element(tier_of_.begin(), tier_of_.end());
+    sdsl::int_vector<> tier(colors.size(), 0, static_cast<std::uint8_t>(sdsl::bits::hi(top | 1u) + 1));
+    for (std::uint64_t k = 0; k < tier.size(); ++k) tier[k] = tier_of_[colors.color(k)];
+    rmq_ = sdsl::rmq_succinct_sct<>(&tier);
+}
+
+int DonorTiers::cheapest(std::uint64_t l, std::uint64_t r) const {
+    return tier(l == r ? l : static_cast<std::uint64_t>(rmq_(l, r)));
+}
+
+int DonorTiers::tier(std::uint64_t k) const {
+    return tier_of_[colors_.color(k)];
+}
+
+const DonorTiers& DonorColors::tiers(const std::vector<std::uint16_t>& tier_of) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::unique_ptr<DonorTiers>& slot = tiers_[tier_of];
+    if (!slot) slot.reset(new DonorTiers(*this, tier_of));
+    return *slot;
+}
+
+// --- COLOUR FILE ---
+
+std::string donor_colors_path(const std::string& index_path) {
+    return index_path + ".colors";
+}
+
+bool DonorColors::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    std::string header;
+    std::getline(in, header);
+    std::stringstream ss(header);
+    std::string magic;
+    size_t count = 0;
+    if (!(ss >> magic >> count) || magic != "donor-colors" || count == 0) return false;
+    names_.resize(count);
+    for (std::string& name : names_) {
+        if (!std::getline(in, name)) return false;
+    }
+    color_.load(in);
+    return static_cast<bool>(in);
+}
+
+bool store_donor_colors(const std::string& path, const std::vector<std::string>& names, const sdsl::int_vector<>& color) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+    out << "donor-colors " << names.size() << "\n";
+    for (const std::string& name : names) out << name << "\n";
+    color.serialize(out);
+    return static_cast<bool>(out);
+}
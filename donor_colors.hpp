@@ -0,0 +1,71 @@
+#pragma once
+// Donor colours of a generalized index over a donor panel.
+//
+// create_index builds one FM-index over all donors of a panel and stores,
+// next to it in <index>.colors, the donor ("colour") of every suffix in
+// suffix array order.  The suffix array interval of a block then holds the
+// donors that contain it, so the panel is searched with one stream of rank
+// queries however many donors it has.  To price a block by its cheapest
+// donor, the donors are ranked into price tiers and a range-minimum
+// structure over the tier of every suffix (2n + o(n) bits) answers the
+// cheapest tier of an interval in O(1).  It depends on the prices, so it is
+// built on first use for each ranking and kept for later records and
+// requests.
+//
+// Neither is compressed: the colours take ceil(log2 D) bits per suffix and
+// each ranking 2 bits more, also for an r-index.  The suffixes of a block's
+// copies in closely related donors sit next to each other in suffix array
+// order, so the colours alternate and do not form runs the way the BWT does;
+// a panel with colours stays linear in its length.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/rmq_support.hpp>
+
+class DonorColors;
+
+// Cheapest price tier among the suffixes of one interval, for one ranking.
+class DonorTiers {
+public:
+    DonorTiers(const DonorColors& colors, std::vector<std::uint16_t> tier_of);
+    // Cheapest tier among suffix array positions [l, r], l <= r.
+    int cheapest(std::uint64_t l, std::uint64_t r) const;
+    // Tier of the donor of suffix array position k.
+    int tier(std::uint64_t k) const;
+
+private:
+    const DonorColors& colors_;
+    std::vector<std::uint16_t> tier_of_;   // by donor
+    sdsl::rmq_succinct_sct<> rmq_;
+};
+
+class DonorColors {
+public:
+    // Loads <index_path>.colors; false (no message) if there is none.
+    bool load(const std::string& path);
+    std::size_t donors() const { return names_.size(); }
+    const std::vector<std::string>& names() const { return names_; }
+    std::uint32_t color(std::uint64_t k) const { return static_cast<std::uint32_t>(color_[k]); }
+    std::uint64_t size() const { return color_.size(); }
+    // The range-minimum structure for tier_of[d] of every donor d, built
+    // once per distinct ranking; safe to call from several threads.
+    const DonorTiers& tiers(const std::vector<std::uint16_t>& tier_of) const;
+
+private:
+    std::vector<std::string> names_;
+    sdsl::int_vector<> color_;
+    mutable std::mutex mu_;
+    mutable std::map<std::vector<std::uint16_t>, std::unique_ptr<DonorTiers>> tiers_;
+};
+
+// Colour file of the index at index_path.
+std::string donor_colors_path(const std::string& index_path);
+// Writes the colour file: the donor names, then color[k] = donor of suffix
+// array position k.
+bool store_donor_colors(const std::string& path, const std::vector<std::string>& names, const sdsl::int_vector<>& color);
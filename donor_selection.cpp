@@ -0,0 +1,450 @@
+#include "donor_selection.hpp"
+#include "self_reuse.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// The sequences the planners would plan: every record, or every region, cut
+// into its gap-free segments with split_gaps.
+bool load_target(const PlannerArgs& args, std::vector<std::string>& seqs) {
+    auto add = [&](const std::string& seq) {
+        if (!args.split_gaps) {
+            if (!seq.empty()) seqs.push_back(seq);
+            return;
+        }
+        for (const Segment& segment : gap_free_segments(seq)) {
+            seqs.push_back(seq.substr(segment.start, segment.end - segment.start));
+        }
+    };
+    if (!args.regions.empty()) {
+        std::vector<Region> regions;
+        if (!parse_regions(args.regions, regions)) return false;
+        IndexedFasta fasta;
+        if (!fasta.open(args.fasta_path)) return false;
+        std::string seq;
+        for (const Region& region : regions) {
+            if (!fasta.fetch(region, seq, args.split_gaps)) return false;
+            add(seq);
+        }
+        return true;
+    }
+    PrefetchFastaReader reader(args.fasta_path, 0, args.split_gaps);
+    if (!reader.is_open()) {
+        std::cerr << "ERROR: Could not open FASTA file: " << args.fasta_path << std::endl;
+        return false;
+    }
+    FastaRecord rec;
+    while (reader.next(rec)) add(rec.seq);
+    return !reader.failed();
+}
+
+// Entries of a profile overwritten by DonorPanel::raise, to put back.
+struct ProfileUndo {
+    std::vector<size_t> pos;
+    std::vector<std::uint16_t> old;   // per position: end_len, then tier_len of every tier
+
+    void clear() {
+        pos.clear();
+        old.clear();
+    }
+};
+
+// Per-donor reuse ends of every record, and the profiles of donor subsets.
+// Each donor's ends are also kept as the runs of positions where it holds a
+// match at all, so adding or removing a donor visits only those.
+class DonorPanel {
+public:
+    DonorPanel(const std::vector<std::string>& seqs, DonorEnds ends, int W, const CostModel& costs)
+        : W_(W), ends_(std::move(ends)) {
+        runs_.resize(ends_.size());
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long d = 0; d < static_cast<long long>(ends_.size()); ++d) {
+            for (const std::vector<std::uint16_t>& e : ends_[static_cast<size_t>(d)]) {
+                std::vector<Run> runs;
+                for (size_t i = 1; i < e.size();) {
+                    if (e[i] == 0) {
+                        ++i;
+                        continue;
+                    }
+                    const size_t from = i;
+                    while (i < e.size() && e[i] > 0) ++i;
+                    runs.push_back({from, i});
+                }
+                runs_[static_cast<size_t>(d)].push_back(std::move(runs));
+            }
+        }
+        // Copies earlier in the record are there whatever the subset.
+        base_.resize(seqs.size());
+        for (size_t r = 0; r < seqs.size(); ++r) {
+            base_[r].assign(seqs[r].length() + 1, 0);
+            if (costs.self_reuse) {
+                const int search_len = (costs.reuse_max > 0) ? std::min(W, costs.reuse_max) : W;
+                add_self_reuse(seqs[r], search_len, std::max(1, costs.reuse_min), base_[r], nullptr);
+            }
+        }
+        // Price tiers as compute_reuse_profile ranks them, over the whole panel.
+        if (!costs.source_pcr.empty()) {
+            tier_pcr_ = costs.source_pcr;
+            std::sort(tier_pcr_.begin(), tier_pcr_.end());
+            tier_pcr_.erase(std::unique(tier_pcr_.begin(), tier_pcr_.end()), tier_pcr_.end());
+            for (const double p : costs.source_pcr) {
+                tier_of_.push_back(static_cast<size_t>(std::lower_bound(tier_pcr_.begin(), tier_pcr_.end(), p) - tier_pcr_.begin()));
+            }
+        }
+    }
+
+    size_t donors() const { return ends_.size(); }
+    size_t records() const { return base_.size(); }
+
+    // Profile of record r with the given donors (start_len is left empty:
+    // only the DP reads these profiles).
+    ReuseProfile profile(size_t r, const std::vector<size_t>& subset) const {
+        ReuseProfile p;
+        p.W = W_;
+        p.end_len = base_[r];
+        p.tier_pcr = tier_pcr_;
+        p.tier_len.assign(tier_pcr_.size(), std::vector<std::uint16_t>(base_[r].size(), 0));
+        std::vector<long long> changed;
+        for (const size_t d : subset) raise(r, d, p, changed, nullptr);
+        return p;
+    }
+
+    // Adds donor d to p, a profile of record r: a longer match, or a cheaper
+    // one in its tier and every dearer tier.  Appends the positions it raises
+    // to changed (ascending), and their old entries to undo if given.
+    void raise(size_t r, size_t d, ReuseProfile& p, std::vector<long long>& changed, ProfileUndo* undo) const {
+        const std::vector<std::uint16_t>& e = ends_[d][r];
+        const size_t tiers = tier_pcr_.size();
+        const size_t first = tier_of_.empty() ? tiers : tier_of_[d];
+        for (const Run& run : runs_[d][r]) {
+            for (size_t i = run.from; i < run.to; ++i) {
+                // tier_len is non-decreasing in t, so the first tier decides.
+                if (!(e[i] > p.end_len[i] || (first < tiers && e[i] > p.tier_len[first][i]))) continue;
+                if (undo) {
+                    undo->pos.push_back(i);
+                    undo->old.push_back(p.end_len[i]);
+                    for (size_t t = 0; t < tiers; ++t) undo->old.push_back(p.tier_len[t][i]);
+                }
+                p.end_len[i] = std::max(p.end_len[i], e[i]);
+                for (size_t t = first; t < tiers; ++t) p.tier_len[t][i] = std::max(p.tier_len[t][i], e[i]);
+                changed.push_back(static_cast<long long>(i));
+            }
+        }
+    }
+
+    // Puts back the entries raise overwrote.
+    void restore(ReuseProfile& p, const ProfileUndo& undo) const {
+        const size_t tiers = tier_pcr_.size();
+        for (size_t k = 0; k < undo.pos.size(); ++k) {
+            const size_t i = undo.pos[k];
+            const std::uint16_t* old = &undo.old[k * (tiers + 1)];
+            p.end_len[i] = old[0];
+            for (size_t t = 0; t < tiers; ++t) p.tier_len[t][i] = old[t + 1];
+        }
+    }
+
+    // Removes donor d from p, the profile of record r with the donors marked
+    // in `in` and d: only where d held the best match is the position rebuilt
+    // from the others, O(donors) each.  Appends the positions lowered.
+    void lower(size_t r, size_t d, const std::vector<char>& in, ReuseProfile& p, std::vector<long long>& changed) const {
+        const std::vector<std::uint16_t>& e = ends_[d][r];
+        const size_t tiers = tier_pcr_.size();
+        const size_t first = tier_of_.empty() ? tiers : tier_of_[d];
+        std::vector<std::uint16_t> tier(tiers);
+        for (const Run& run : runs_[d][r]) {
+            for (size_t i = run.from; i < run.to; ++i) {
+                if (!(e[i] == p.end_len[i] || (first < tiers && e[i] == p.tier_len[first][i]))) continue;
+                std::uint16_t len = base_[r][i];
+                std::fill(tier.begin(), tier.end(), 0);
+                for (size_t o = 0; o < ends_.size(); ++o) {
+                    if (!in[o]) continue;
+                    const std::uint16_t v = ends_[o][r][i];
+                    len = std::max(len, v);
+                    for (size_t t = tier_of_.empty() ? tiers : tier_of_[o]; t < tiers; ++t) tier[t] = std::max(tier[t], v);
+                }
+                bool lowered = len != p.end_len[i];
+                p.end_len[i] = len;
+                for (size_t t = 0; t < tiers; ++t) {
+                    lowered = lowered || tier[t] != p.tier_len[t][i];
+                    p.tier_len[t][i] = tier[t];
+                }
+                if (lowered) changed.push_back(static_cast<long long>(i));
+            }
+        }
+    }
+
+private:
+    struct Run {
+        size_t from, to;   // positions [from, to) where the donor holds a match
+    };
+
+    int W_;
+    DonorEnds ends_;                                              // [donor][record]
+    std::vector<std::vector<std::vector<Run>>> runs_;             // [donor][record]
+    std::vector<std::vector<std::uint16_t>> base_;                // self-reuse, or zeros
+    std::vector<double> tier_pcr_;
+    std::vector<size_t> tier_of_;                                 // by donor
+};
+
+// a is a strictly lower cost than b, beyond rounding.
+bool cheaper(double a, double b) {
+    return a < b - 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+// Forward selection: at every k the donor whose addition costs least (the
+// lowest-numbered one on ties).  Each record tries every candidate against
+// its current plan, raising its profile in place and putting it back, so
+// records run in parallel and candidates one after another.
+void greedy_curve(const DonorPanel& panel, const std::vector<std::string>& seqs, const CostModel& costs, int max_k,
+                  std::vector<DonorSubset>& curve) {
+    const size_t R = panel.records();
+    const size_t D = panel.donors();
+    std::vector<ReuseProfile> current;
+    std::vector<DpSession> sessions;
+    DonorSubset subset;
+    for (size_t r = 0; r < R; ++r) {
+        current.push_back(panel.profile(r, {}));
+        sessions.emplace_back(seqs[r], current[r], costs);
+        subset.cost += sessions[r].cost();
+    }
+    curve.push_back(subset);
+    std::vector<char> taken(D, 0);
+    std::vector<std::vector<double>> with(R, std::vector<double>(D, 0.0));   // [record][donor]
+    for (int k = 1; k <= max_k; ++k) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long r = 0; r < static_cast<long long>(R); ++r) {
+            const size_t rec = static_cast<size_t>(r);
+            std::vector<long long> changed;
+            ProfileUndo undo;
+            for (size_t d = 0; d < D; ++d) {
+                if (taken[d]) continue;
+                changed.clear();
+                undo.clear();
+                panel.raise(rec, d, current[rec], changed, &undo);
+                with[rec][d] = changed.empty() ? sessions[rec].cost() : sessions[rec].evaluate(current[rec], changed);
+                panel.restore(current[rec], undo);
+            }
+        }
+        size_t best = D;
+        double best_cost = 0.0;
+        for (size_t d = 0; d < D; ++d) {
+            if (taken[d]) continue;
+            double total = 0.0;
+            for (size_t r = 0; r < R; ++r) total += with[r][d];
+            if (best == D || cheaper(total, best_cost)) {
+                best = d;
+                best_cost = total;
+            }
+        }
+        taken[best] = 1;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long r = 0; r < static_cast<long long>(R); ++r) {
+            const size_t rec = static_cast<size_t>(r);
+            std::vector<long long> changed;
+            panel.raise(rec, best, current[rec], changed, nullptr);
+            if (!changed.empty()) sessions[rec].adopt(current[rec]);
+        }
+        subset.k = k;
+        subset.donors.push_back(best);
+        subset.cost = 0.0;
+        for (const DpSession& session : sessions) subset.cost += session.cost();
+        curve.push_back(subset);
+    }
+}
+
+// Branch-and-bound over subsets of k donors, improving on the greedy subset
+// already in curve[k].  Donors are branched on in greedy order, taken first.
+// Every subset is evaluated against the plan with the whole panel, which a
+// bound (a subset plus every undecided donor) is close to.  The search keeps
+// the profile of the donors still in play (taken or undecided) and updates
+// it as donors are decided against and put back, along with the positions
+// where it differs from the whole panel's, which are what evaluate re-solves.
+class SubsetSearch {
+public:
+    SubsetSearch(const DonorPanel& panel, const std::vector<std::string>& seqs, const CostModel& costs,
+                 std::vector<size_t> order)
+        : panel_(panel), order_(std::move(order)), in_(panel.donors(), 1), records_(panel.records()) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long r = 0; r < static_cast<long long>(records_.size()); ++r) {
+            Record& rec = records_[static_cast<size_t>(r)];
+            rec.full = panel.profile(static_cast<size_t>(r), order_);
+            rec.current = rec.full;
+            rec.differs.assign(rec.full.end_len.size(), 0);
+        }
+        for (size_t r = 0; r < records_.size(); ++r) sessions_.emplace_back(seqs[r], records_[r].full, costs);
+    }
+
+    void improve(DonorSubset& best) {
+        best_ = &best;
+        std::vector<size_t> chosen;
+        search(0, chosen, std::numeric_limits<double>::quiet_NaN());
+    }
+
+private:
+    struct Record {
+        ReuseProfile full;              // every donor: the sessions' reference
+        ReuseProfile current;           // the donors in play
+        std::vector<char> differs;      // current differs from full at i
+        std::vector<long long> marked;  // every i set in differs (and stale ones)
+    };
+
+    // Records whether current differs from full at the positions in changed.
+    void mark(Record& rec, const std::vector<long long>& changed) const {
+        for (const long long x : changed) {
+            const size_t i = static_cast<size_t>(x);
+            bool differs = rec.current.end_len[i] != rec.full.end_len[i];
+            for (size_t t = 0; t < rec.full.tier_len.size() && !differs; ++t) {
+                differs = rec.current.tier_len[t][i] != rec.full.tier_len[t][i];
+            }
+            if (differs && !rec.differs[i]) rec.marked.push_back(x);
+            rec.differs[i] = differs;
+        }
+    }
+
+    // Takes donor d out of play, or puts it back.
+    void drop(size_t d) {
+        in_[d] = 0;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long r = 0; r < static_cast<long long>(records_.size()); ++r) {
+            Record& rec = records_[static_cast<size_t>(r)];
+            std::vector<long long> changed;
+            panel_.lower(static_cast<size_t>(r), d, in_, rec.current, changed);
+            mark(rec, changed);
+        }
+    }
+
+    void restore(size_t d) {
+        in_[d] = 1;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long r = 0; r < static_cast<long long>(records_.size()); ++r) {
+            Record& rec = records_[static_cast<size_t>(r)];
+            std::vector<long long> changed;
+            panel_.raise(static_cast<size_t>(r), d, rec.current, changed, nullptr);
+            mark(rec, changed);
+        }
+    }
+
+    // Cost of the donors in play.
+    double cost() {
+        double total = 0.0;
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+ : total)
+        for (long long r = 0; r < static_cast<long long>(records_.size()); ++r) {
+            Record& rec = records_[static_cast<size_t>(r)];
+            std::vector<long long>& marked = rec.marked;
+            marked.erase(std::remove_if(marked.begin(), marked.end(),
+                                        [&rec](long long i) { return !rec.differs[static_cast<size_t>(i)]; }),
+                         marked.end());
+            std::sort(marked.begin(), marked.end());
+            marked.erase(std::unique(marked.begin(), marked.end()), marked.end());
+            total += sessions_[static_cast<size_t>(r)].evaluate(rec.current, marked);
+        }
+        return total;
+    }
+
+    // bound: the cost of chosen plus order_[next..] if known, else NaN.  On
+    // entry and exit the donors in play are exactly those.
+    void search(size_t next, std::vector<size_t>& chosen, double bound) {
+        const size_t need = static_cast<size_t>(best_->k) - chosen.size();
+        const size_t left = order_.size() - next;
+        if (left < need) return;
+        if (need == 0) {
+            for (size_t t = next; t < order_.size(); ++t) drop(order_[t]);
+            const double c = cost();
+            for (size_t t = next; t < order_.size(); ++t) restore(order_[t]);
+            if (cheaper(c, best_->cost)) {
+                best_->cost = c;
+                best_->donors = chosen;
+            }
+            return;
+        }
+        if (std::isnan(bound)) bound = cost();
+        if (!cheaper(bound, best_->cost)) return;
+        if (left == need) {
+            best_->cost = bound;
+            best_->donors = chosen;
+            best_->donors.insert(best_->donors.end(), order_.begin() + static_cast<long long>(next), order_.end());
+            return;
+        }
+        // Taking order_[next] leaves the same bound.
+        chosen.push_back(order_[next]);
+        search(next + 1, chosen, bound);
+        chosen.pop_back();
+        drop(order_[next]);
+        search(next + 1, chosen, std::numeric_limits<double>::quiet_NaN());
+        restore(order_[next]);
+    }
+
+    const DonorPanel& panel_;
+    std::vector<size_t> order_;
+    std::vector<char> in_;            // by donor: in play
+    std::vector<Record> records_;
+    std::vector<DpSession> sessions_;
+    DonorSubset* best_ = nullptr;
+};
+
+} // namespace
+
+bool select_donor_subsets(const PlannerArgs& args, int max_k, bool exact, std::vector<DonorSubset>& curve,
+                          std::vector<std::string>& names) {
+    CostModel costs = args.costs;
+    costs.synth_reusable = true;
+    const char* unsupported = costs.counts_occurrences() ? "--multi-penalty / --unique-only"
+                            : costs.max_mismatches > 0  ? "--mismatches"
+                            : costs.circular            ? "--circular"
+                            : !costs.levels.empty()     ? "--levels"
+                                                        : nullptr;
+    if (unsupported) {
+        std::cerr << "ERROR: Donor selection does not support " << unsupported << std::endl;
+        return false;
+    }
+    SourceIndex source;
+    if (!load_source_index(args.index_path, source)) return false;
+    names = source.donor_names();
+    if (!costs.source_pcr.empty() && costs.source_pcr.size() != source.donors()) {
+        std::cerr << "ERROR: --source-pcr gives " << costs.source_pcr.size() << " prices for " << source.donors()
+                  << " source donors" << std::endl;
+        return false;
+    }
+    std::vector<std::string> seqs;
+    if (!load_target(args, seqs)) return false;
+
+    DonorEnds ends = donor_reuse_ends(seqs, args.W, source, costs.reuse_min, costs.reuse_max);
+    donor_subset_curve(seqs, std::move(ends), args.W, costs, max_k, exact, curve);
+    return true;
+}
+
+void donor_subset_curve(const std::vector<std::string>& seqs, DonorEnds ends, int W, const CostModel& costs, int max_k,
+                        bool exact, std::vector<DonorSubset>& curve) {
+    const DonorPanel panel(seqs, std::move(ends), W, costs);
+    const int D = static_cast<int>(panel.donors());
+    if (max_k < 0 || max_k > D) max_k = D;
+    curve.clear();
+    greedy_curve(panel, seqs, costs, max_k, curve);
+    if (!exact || max_k == 0) return;
+
+    // Greedy picks first, then the rest in panel order.
+    std::vector<size_t> order = curve.back().donors;
+    for (size_t d = 0; d < panel.donors(); ++d) {
+        if (std::find(order.begin(), order.end(), d) == order.end()) order.push_back(d);
+    }
+    SubsetSearch search(panel, seqs, costs, order);
+    for (int k = 1; k < D && k <= max_k; ++k) search.improve(curve[static_cast<size_t>(k)]);
+}
+
+int run_donor_selection(const PlannerArgs& args, int max_k, bool exact) {
+    std::vector<DonorSubset> curve;
+    std::vector<std::string> names;
+    if (!select_donor_subsets(args, max_k, exact, curve, names)) return 1;
+    for (const DonorSubset& subset : curve) {
+        std::cout << subset.k << "," << subset.cost << ",";
+        for (size_t n = 0; n < subset.donors.size(); ++n) {
+            std::cout << (n > 0 ? ";" : "") << names[subset.donors[n]];
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+// Donor-subset selection.
+//
+// Which k donors of a panel to stock so that a target set is cheapest to
+// build.  Every target record is searched once per donor
+// (donor_reuse_ends); the reuse profile of a subset is then the maximum of
+// its donors' arrays at every position, and its cost the sum of the
+// records' DP costs.  A donor changes the profile only where it holds a
+// longer match than the subset (or a cheaper one, with per-donor prices),
+// and each record's DP is re-solved from there (DpSession).  Profiles are
+// raised and lowered in place over the runs where a donor holds a match, so
+// trying a donor costs about the stretches it improves, not a pass over the
+// target.
+//
+// Reusable blocks may still be synthesised (CostModel::synth_reusable): a
+// donor in stock need not be used, so more donors never cost more.  Greedy
+// selection adds, for k = 1, 2, ..., the donor that lowers the cost most.
+// Exact selection runs a branch-and-bound per k seeded with the greedy
+// subset: by that monotonicity a partial subset together with every donor
+// not yet decided against bounds all of its completions.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "planner_core.hpp"
+
+// One point of the cost curve: the best subset found of k donors.
+struct DonorSubset {
+    int k = 0;
+    double cost = 0.0;
+    std::vector<size_t> donors;   // SourceIndex::donors order; greedy: in order added
+};
+
+// Selects subsets of 0 .. max_k donors of args.index_path for the records
+// (or regions, or gap-free segments) of args.fasta_path, planned with the DP
+// under args.costs with synth_reusable set.  Occurrence rules, mismatches, circular records and
+// levels are rejected: they are not functions of the per-donor arrays.
+// Prints an error and returns false on bad input.
+bool select_donor_subsets(const PlannerArgs& args, int max_k, bool exact, std::vector<DonorSubset>& curve,
+                          std::vector<std::string>& names);
+
+// Per-donor reuse ends, ends[d][r] (donor_reuse_ends).
+using DonorEnds = std::vector<std::vector<std::vector<std::uint16_t>>>;
+
+// The search behind select_donor_subsets, over records seqs whose ends are
+// given: the greedy curve for 0 .. max_k donors (all if max_k < 0), each
+// subset then improved by branch-and-bound if exact.  costs as
+// select_donor_subsets checks them, with synth_reusable set.
+void donor_subset_curve(const std::vector<std::string>& seqs, DonorEnds ends, int W, const CostModel& costs, int max_k,
+                        bool exact, std::vector<DonorSubset>& curve);
+
+// Runs select_donor_subsets and writes the curve to stdout, one CSV row per
+// k: k, total_cost, donors (names separated by ';').
+int run_donor_selection(const PlannerArgs& args, int max_k, bool exact);
@@ -0,0 +1,303 @@
+#include "dp_kernels.hpp"
+
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLANNER_X86 1
+// GCC's _mm512_reduce_* helpers start from a self-initialised "__Y = __Y"
+// placeholder, which -Wmaybe-uninitialized reports at every inlined call site.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#endif
+
+// --- MIN/ARGMIN KERNELS ---
+
+namespace {
+
+// AddC = false drops the "+ c" (models without joins) instead of adding zero.
+template <typename T, bool AddC>
+MinArg<T> min_plus_argmin_scalar(const T* a, const T* b, T c, size_t n) {
+    MinArg<T> best{std::numeric_limits<T>::max(), -1};
+    for (size_t k = 0; k < n; ++k) {
+        const T v = AddC ? a[k] + b[k] + c : a[k] + b[k];
+        if (v <= best.value) best = {v, static_cast<long long>(k)};
+    }
+    return best;
+}
+
+// Folds per-lane results (value, last index) into one, then scans the tail.
+template <bool AddC, typename T, typename I>
+MinArg<T> finish_lanes(const T* vals, const I* idxs, int lanes, const T* a, const T* b, T c, size_t k, size_t n) {
+    MinArg<T> out{std::numeric_limits<T>::max(), -1};
+    for (int l = 0; l < lanes; ++l) {
+        const long long li = static_cast<long long>(idxs[l]);
+        if (vals[l] < out.value || (vals[l] == out.value && li > out.index)) out = {vals[l], li};
+    }
+    for (; k < n; ++k) {
+        const T v = AddC ? a[k] + b[k] + c : a[k] + b[k];
+        if (v <= out.value) out = {v, static_cast<long long>(k)};
+    }
+    return out;
+}
+
+// Lanes keep their own minimum and its last index ("<=" on ties); the final
+// reduction takes the smallest value and, among equal lanes, the largest index.
+// Double indices are carried as doubles, which is exact far beyond any block length.
+#ifdef PLANNER_X86
+template <bool AddC>
+__attribute__((target("avx2")))
+MinArg<double> min_plus_argmin_avx2(const double* a, const double* b, double c, size_t n) {
+    if (n < 16) return min_plus_argmin_scalar<double, AddC>(a, b, c, n);
+    // Two independent accumulators hide the blend latency; lane l of acc0
+    // sees k = 8m + l and of acc1 k = 8m + 4 + l.
+    const __m256d vc = _mm256_set1_pd(c);
+    const __m256d step = _mm256_set1_pd(8.0);
+    __m256d idx0 = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+    __m256d idx1 = _mm256_setr_pd(4.0, 5.0, 6.0, 7.0);
+    __m256d best0 = _mm256_set1_pd(std::numeric_limits<double>::max()), best1 = best0;
+    __m256d best_idx0 = _mm256_set1_pd(-1.0), best_idx1 = best_idx0;
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256d v0 = _mm256_add_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k));
+        if (AddC) v0 = _mm256_add_pd(v0, vc);
+        __m256d v1 = _mm256_add_pd(_mm256_loadu_pd(a + k + 4), _mm256_loadu_pd(b + k + 4));
+        if (AddC) v1 = _mm256_add_pd(v1, vc);
+        const __m256d le0 = _mm256_cmp_pd(v0, best0, _CMP_LE_OQ);
+        const __m256d le1 = _mm256_cmp_pd(v1, best1, _CMP_LE_OQ);
+        best0 = _mm256_blendv_pd(best0, v0, le0);
+        best1 = _mm256_blendv_pd(best1, v1, le1);
+        best_idx0 = _mm256_blendv_pd(best_idx0, idx0, le0);
+        best_idx1 = _mm256_blendv_pd(best_idx1, idx1, le1);
+        idx0 = _mm256_add_pd(idx0, step);
+        idx1 = _mm256_add_pd(idx1, step);
+    }
+    alignas(32) double vals[8], idxs[8];
+    _mm256_store_pd(vals, best0);
+    _mm256_store_pd(vals + 4, best1);
+    _mm256_store_pd(idxs, best_idx0);
+    _mm256_store_pd(idxs + 4, best_idx1);
+    return finish_lanes<AddC>(vals, idxs, 8, a, b, c, k, n);
+}
+
+// Integer lanes: "v <= best" is "not (v > best)", so the blends select best
+// where v > best.
+template <bool AddC>
+__attribute__((target("avx2")))
+MinArg<std::int32_t> min_plus_argmin_avx2(const std::int32_t* a, const std::int32_t* b, std::int32_t c, size_t n) {
+    if (n < 32) return min_plus_argmin_scalar<std::int32_t, AddC>(a, b, c, n);
+    const __m256i vc = _mm256_set1_epi32(c);
+    const __m256i step = _mm256_set1_epi32(16);
+    __m256i idx0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i idx1 = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+    __m256i best0 = _mm256_set1_epi32(std::numeric_limits<std::int32_t>::max()), best1 = best0;
+    __m256i best_idx0 = _mm256_set1_epi32(-1), best_idx1 = best_idx0;
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m256i v0 = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + k)));
+        if (AddC) v0 = _mm256_add_epi32(v0, vc);
+        __m256i v1 = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k + 8)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + k + 8)));
+        if (AddC) v1 = _mm256_add_epi32(v1, vc);
+        const __m256i gt0 = _mm256_cmpgt_epi32(v0, best0);
+        const __m256i gt1 = _mm256_cmpgt_epi32(v1, best1);
+        best0 = _mm256_blendv_epi8(v0, best0, gt0);
+        best1 = _mm256_blendv_epi8(v1, best1, gt1);
+        best_idx0 = _mm256_blendv_epi8(idx0, best_idx0, gt0);
+        best_idx1 = _mm256_blendv_epi8(idx1, best_idx1, gt1);
+        idx0 = _mm256_add_epi32(idx0, step);
+        idx1 = _mm256_add_epi32(idx1, step);
+    }
+    alignas(32) std::int32_t vals[16], idxs[16];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(vals), best0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(vals + 8), best1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idxs), best_idx0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idxs + 8), best_idx1);
+    return finish_lanes<AddC>(vals, idxs, 16, a, b, c, k, n);
+}
+
+template <bool AddC>
+__attribute__((target("avx2")))
+MinArg<std::int64_t> min_plus_argmin_avx2(const std::int64_t* a, const std::int64_t* b, std::int64_t c, size_t n) {
+    if (n < 16) return min_plus_argmin_scalar<std::int64_t, AddC>(a, b, c, n);
+    const __m256i vc = _mm256_set1_epi64x(c);
+    const __m256i step = _mm256_set1_epi64x(4);
+    __m256i idx = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i best = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max());
+    __m256i best_idx = _mm256_set1_epi64x(-1);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256i v = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + k)));
+        if (AddC) v = _mm256_add_epi64(v, vc);
+        const __m256i gt = _mm256_cmpgt_epi64(v, best);
+        best = _mm256_blendv_epi8(v, best, gt);
+        best_idx = _mm256_blendv_epi8(idx, best_idx, gt);
+        idx = _mm256_add_epi64(idx, step);
+    }
+    alignas(32) std::int64_t vals[4], idxs[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(vals), best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idxs), best_idx);
+    return finish_lanes<AddC>(vals, idxs, 4, a, b, c, k, n);
+}
+
+template <bool AddC>
+__attribute__((target("avx512f")))
+MinArg<double> min_plus_argmin_avx512(const double* a, const double* b, double c, size_t n) {
+    if (n < 16) return min_plus_argmin_scalar<double, AddC>(a, b, c, n);
+    const __m512d vc = _mm512_set1_pd(c);
+    const __m512d step = _mm512_set1_pd(8.0);
+    __m512d idx = _mm512_setr_pd(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    __m512d best = _mm512_set1_pd(std::numeric_limits<double>::max());
+    __m512d best_idx = _mm512_set1_pd(-1.0);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512d v = _mm512_add_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k));
+        if (AddC) v = _mm512_add_pd(v, vc);
+        const __mmask8 le = _mm512_cmp_pd_mask(v, best, _CMP_LE_OQ);
+        best = _mm512_mask_mov_pd(best, le, v);
+        best_idx = _mm512_mask_mov_pd(best_idx, le, idx);
+        idx = _mm512_add_pd(idx, step);
+    }
+    const double lo = _mm512_reduce_min_pd(best);
+    const __mmask8 at_min = _mm512_cmp_pd_mask(best, _mm512_set1_pd(lo), _CMP_EQ_OQ);
+    MinArg<double> out{lo, static_cast<long long>(_mm512_mask_reduce_max_pd(at_min, best_idx))};
+    for (; k < n; ++k) {
+        const double v = AddC ? a[k] + b[k] + c : a[k] + b[k];
+        if (v <= out.value) out = {v, static_cast<long long>(k)};
+    }
+    return out;
+}
+
+template <bool AddC>
+__attribute__((target("avx512f")))
+MinArg<std::int32_t> min_plus_argmin_avx512(const std::int32_t* a, const std::int32_t* b, std::int32_t c, size_t n) {
+    if (n < 32) return min_plus_argmin_scalar<std::int32_t, AddC>(a, b, c, n);
+    const __m512i vc = _mm512_set1_epi32(c);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i idx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i best = _mm512_set1_epi32(std::numeric_limits<std::int32_t>::max());
+    __m512i best_idx = _mm512_set1_epi32(-1);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i v = _mm512_add_epi32(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k));
+        if (AddC) v = _mm512_add_epi32(v, vc);
+        const __mmask16 le = _mm512_cmple_epi32_mask(v, best);
+        best = _mm512_mask_mov_epi32(best, le, v);
+        best_idx = _mm512_mask_mov_epi32(best_idx, le, idx);
+        idx = _mm512_add_epi32(idx, step);
+    }
+    const std::int32_t lo = _mm512_reduce_min_epi32(best);
+    const __mmask16 at_min = _mm512_cmpeq_epi32_mask(best, _mm512_set1_epi32(lo));
+    MinArg<std::int32_t> out{lo, static_cast<long long>(_mm512_mask_reduce_max_epi32(at_min, best_idx))};
+    for (; k < n; ++k) {
+        const std::int32_t v = AddC ? a[k] + b[k] + c : a[k] + b[k];
+        if (v <= out.value) out = {v, static_cast<long long>(k)};
+    }
+    return out;
+}
+
+template <bool AddC>
+__attribute__((target("avx512f")))
+MinArg<std::int64_t> min_plus_argmin_avx512(const std::int64_t* a, const std::int64_t* b, std::int64_t c, size_t n) {
+    if (n < 16) return min_plus_argmin_scalar<std::int64_t, AddC>(a, b, c, n);
+    const __m512i vc = _mm512_set1_epi64(c);
+    const __m512i step = _mm512_set1_epi64(8);
+    __m512i idx = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    __m512i best = _mm512_set1_epi64(std::numeric_limits<std::int64_t>::max());
+    __m512i best_idx = _mm512_set1_epi64(-1);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512i v = _mm512_add_epi64(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k));
+        if (AddC) v = _mm512_add_epi64(v, vc);
+        const __mmask8 le = _mm512_cmple_epi64_mask(v, best);
+        best = _mm512_mask_mov_epi64(best, le, v);
+        best_idx = _mm512_mask_mov_epi64(best_idx, le, idx);
+        idx = _mm512_add_epi64(idx, step);
+    }
+    const std::int64_t lo = _mm512_reduce_min_epi64(best);
+    const __mmask8 at_min = _mm512_cmpeq_epi64_mask(best, _mm512_set1_epi64(lo));
+    MinArg<std::int64_t> out{lo, static_cast<long long>(_mm512_mask_reduce_max_epi64(at_min, best_idx))};
+    for (; k < n; ++k) {
+        const std::int64_t v = AddC ? a[k] + b[k] + c : a[k] + b[k];
+        if (v <= out.value) out = {v, static_cast<long long>(k)};
+    }
+    return out;
+}
+#endif
+
+template <typename T>
+using MinArgFn = MinArg<T> (*)(const T*, const T*, T, size_t);
+// One entry per cost type: with and without the "+ c" term.
+template <typename T>
+struct KernelPair {
+    MinArgFn<T> with_c;
+    MinArgFn<T> without_c;
+};
+struct DpKernel {
+    KernelPair<double> f64;
+    KernelPair<std::int32_t> i32;
+    KernelPair<std::int64_t> i64;
+    const char* name;
+};
+
+DpKernel select_dp_kernel() {
+    const char* forced = std::getenv("PLANNER_SIMD");
+    const std::string want = forced ? forced : "";
+#ifdef PLANNER_X86
+    __builtin_cpu_init();
+    const bool narrow = (want == "scalar" || want == "sse42");
+    if (!narrow && want != "avx2" && __builtin_cpu_supports("avx512f")) {
+        return {{min_plus_argmin_avx512<true>, min_plus_argmin_avx512<false>},
+                {min_plus_argmin_avx512<true>, min_plus_argmin_avx512<false>},
+                {min_plus_argmin_avx512<true>, min_plus_argmin_avx512<false>}, "avx512"};
+    }
+    if (!narrow && __builtin_cpu_supports("avx2")) {
+        return {{min_plus_argmin_avx2<true>, min_plus_argmin_avx2<false>},
+                {min_plus_argmin_avx2<true>, min_plus_argmin_avx2<false>},
+                {min_plus_argmin_avx2<true>, min_plus_argmin_avx2<false>}, "avx2"};
+    }
+#endif
+    return {{min_plus_argmin_scalar<double, true>, min_plus_argmin_scalar<double, false>},
+            {min_plus_argmin_scalar<std::int32_t, true>, min_plus_argmin_scalar<std::int32_t, false>},
+            {min_plus_argmin_scalar<std::int64_t, true>, min_plus_argmin_scalar<std::int64_t, false>}, "scalar"};
+}
+
+const DpKernel& dp_kernel() {
+    static const DpKernel kernel = select_dp_kernel();
+    return kernel;
+}
+
+} // namespace
+
+MinArg<double> min_plus_argmin(const double* a, const double* b, double c, size_t n) {
+    return dp_kernel().f64.with_c(a, b, c, n);
+}
+
+MinArg<std::int32_t> min_plus_argmin(const std::int32_t* a, const std::int32_t* b, std::int32_t c, size_t n) {
+    return dp_kernel().i32.with_c(a, b, c, n);
+}
+
+MinArg<std::int64_t> min_plus_argmin(const std::int64_t* a, const std::int64_t* b, std::int64_t c, size_t n) {
+    return dp_kernel().i64.with_c(a, b, c, n);
+}
+
+MinArg<double> min_plus_argmin(const double* a, const double* b, size_t n) {
+    return dp_kernel().f64.without_c(a, b, 0.0, n);
+}
+
+MinArg<std::int32_t> min_plus_argmin(const std::int32_t* a, const std::int32_t* b, size_t n) {
+    return dp_kernel().i32.without_c(a, b, 0, n);
+}
+
+MinArg<std::int64_t> min_plus_argmin(const std::int64_t* a, const std::int64_t* b, size_t n) {
+    return dp_kernel().i64.without_c(a, b, 0, n);
+}
+
+const char* dp_kernel_name() {
+    return dp_kernel().name;
+}
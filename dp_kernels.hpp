@@ -0,0 +1,32 @@
+#pragma once
+// Vector kernels for the inner loop of the DP planner.
+
+#include <cstddef>
+#include <cstdint>
+
+// Smallest (a[k] + b[k]) + c over k in [0, n), and the largest k that attains
+// it (index -1 when n == 0).  The sum is evaluated in exactly that order, so
+// results match the scalar expression bit for bit.  The DP scans j ascending
+// while block length w = i - j descends, so "largest k" is the shortest block,
+// which is the tie-break of the original w-ascending loop.
+//
+// The integer overloads serve the fixed-point cost mode; callers guarantee
+// that no sum overflows.  int32 runs twice as many lanes per instruction.
+template <typename T>
+struct MinArg {
+    T value;
+    long long index;
+};
+MinArg<double> min_plus_argmin(const double* a, const double* b, double c, size_t n);
+MinArg<std::int32_t> min_plus_argmin(const std::int32_t* a, const std::int32_t* b, std::int32_t c, size_t n);
+MinArg<std::int64_t> min_plus_argmin(const std::int64_t* a, const std::int64_t* b, std::int64_t c, size_t n);
+
+// Same without the constant term: smallest a[k] + b[k].
+MinArg<double> min_plus_argmin(const double* a, const double* b, size_t n);
+MinArg<std::int32_t> min_plus_argmin(const std::int32_t* a, const std::int32_t* b, size_t n);
+MinArg<std::int64_t> min_plus_argmin(const std::int64_t* a, const std::int64_t* b, size_t n);
+
+// "avx512", "avx2" or "scalar": AVX-512F or AVX2 when the CPU supports them
+// (selected once at startup; PLANNER_SIMD=avx512|avx2|sse42|scalar overrides
+// the choice, sse42 meaning scalar here).
+const char* dp_kernel_name();
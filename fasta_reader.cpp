@@ -0,0 +1,542 @@
+#include "fasta_reader.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLANNER_X86 1
+#endif
+
+// --- CLEANING KERNELS ---
+
+namespace {
+
+// Output byte for every input byte; 0 means the byte is dropped.
+//   default:   A/C/G/T in either case -> upper case, everything else dropped
+//   keep_gaps: A/C/G/T -> upper case, whitespace and control bytes dropped,
+//              every other byte (N, IUPAC codes, '-', ...) -> 'N'
+struct BaseTable {
+    std::uint8_t v[256];
+    constexpr explicit BaseTable(bool keep_gaps) : v{} {
+        for (int c = 0x21; c < 256; ++c) v[c] = keep_gaps ? 'N' : 0;
+        v['A'] = v['a'] = 'A';
+        v['C'] = v['c'] = 'C';
+        v['G'] = v['g'] = 'G';
+        v['T'] = v['t'] = 'T';
+    }
+};
+constexpr BaseTable kBases(false);
+constexpr BaseTable kGapBases(true);
+
+template <bool KeepGaps>
+size_t clean_bases_scalar(const char* in, size_t len, char* out) {
+    const BaseTable& table = KeepGaps ? kGapBases : kBases;
+    size_t n = 0;
+    for (size_t k = 0; k < len; ++k) {
+        const std::uint8_t b = table.v[static_cast<std::uint8_t>(in[k])];
+        out[n] = static_cast<char>(b);   // n <= k, so this never runs past the input length
+        n += (b != 0);
+    }
+    return n;
+}
+
+#ifdef PLANNER_X86
+// pshufb control that packs the bytes selected by an 8-bit mask to the front.
+struct LeftPackTable {
+    std::uint8_t v[256][8];
+    constexpr LeftPackTable() : v{} {
+        for (int m = 0; m < 256; ++m) {
+            int n = 0;
+            for (int b = 0; b < 8; ++b) {
+                if (m & (1 << b)) v[m][n++] = static_cast<std::uint8_t>(b);
+            }
+            for (; n < 8; ++n) v[m][n] = 0x80;
+        }
+    }
+};
+constexpr LeftPackTable kLeftPack;
+
+// Upper-casing is c & 0xDF; only 'A'/'a' map to 'A' (likewise C, G, T), so
+// comparing the masked byte against the four bases classifies exactly.
+__attribute__((target("sse4.2,popcnt")))
+inline __m128i base_mask_sse(__m128i u) {
+    const __m128i ok_ac = _mm_or_si128(_mm_cmpeq_epi8(u, _mm_set1_epi8('A')), _mm_cmpeq_epi8(u, _mm_set1_epi8('C')));
+    const __m128i ok_gt = _mm_or_si128(_mm_cmpeq_epi8(u, _mm_set1_epi8('G')), _mm_cmpeq_epi8(u, _mm_set1_epi8('T')));
+    return _mm_or_si128(ok_ac, ok_gt);
+}
+
+// Packs the valid bytes of 16 upper-cased bytes to out, 8 at a time.  Each
+// store writes 8 bytes, which stays inside the input length (out <= input offset).
+__attribute__((target("sse4.2,popcnt")))
+inline size_t pack16(__m128i u, unsigned m, char* out) {
+    const unsigned lo = m & 0xFFu;
+    const unsigned hi = (m >> 8) & 0xFFu;
+    const __m128i p0 = _mm_shuffle_epi8(u, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kLeftPack.v[lo])));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), p0);
+    size_t n = static_cast<size_t>(__builtin_popcount(lo));
+    const __m128i p1 = _mm_shuffle_epi8(_mm_srli_si128(u, 8), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kLeftPack.v[hi])));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + n), p1);
+    return n + static_cast<size_t>(__builtin_popcount(hi));
+}
+
+// Classifies 16 bytes: returns the bytes to emit and sets keep to the mask of
+// bytes that are not dropped.
+template <bool KeepGaps>
+__attribute__((target("sse4.2,popcnt")))
+inline __m128i classify16(__m128i x, unsigned& keep) {
+    const __m128i u = _mm_and_si128(x, _mm_set1_epi8(static_cast<char>(0xDF)));
+    const __m128i is_base = base_mask_sse(u);
+    if (!KeepGaps) {
+        keep = static_cast<unsigned>(_mm_movemask_epi8(is_base));
+        return u;
+    }
+    const __m128i printable = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(0x21)), x);   // x >= 0x21
+    keep = static_cast<unsigned>(_mm_movemask_epi8(printable));
+    return _mm_blendv_epi8(_mm_set1_epi8('N'), u, is_base);
+}
+
+template <bool KeepGaps>
+__attribute__((target("sse4.2,popcnt")))
+size_t clean_bases_sse42(const char* in, size_t len, char* out) {
+    size_t k = 0, n = 0;
+    for (; k + 16 <= len; k += 16) {
+        unsigned m = 0;
+        const __m128i v = classify16<KeepGaps>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + k)), m);
+        if (m == 0xFFFFu) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), v);
+            n += 16;
+        } else if (m != 0) {
+            n += pack16(v, m, out + n);
+        }
+    }
+    return n + clean_bases_scalar<KeepGaps>(in + k, len - k, out + n);
+}
+
+template <bool KeepGaps>
+__attribute__((target("avx2,popcnt")))
+size_t clean_bases_avx2(const char* in, size_t len, char* out) {
+    const __m256i upper = _mm256_set1_epi8(static_cast<char>(0xDF));
+    const __m256i a = _mm256_set1_epi8('A'), c = _mm256_set1_epi8('C');
+    const __m256i g = _mm256_set1_epi8('G'), t = _mm256_set1_epi8('T');
+    size_t k = 0, n = 0;
+    for (; k + 32 <= len; k += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + k));
+        const __m256i u = _mm256_and_si256(x, upper);
+        const __m256i ok = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(u, a), _mm256_cmpeq_epi8(u, c)),
+                                           _mm256_or_si256(_mm256_cmpeq_epi8(u, g), _mm256_cmpeq_epi8(u, t)));
+        __m256i v = u;
+        unsigned m = 0;
+        if (KeepGaps) {
+            const __m256i printable = _mm256_cmpeq_epi8(_mm256_max_epu8(x, _mm256_set1_epi8(0x21)), x);
+            m = static_cast<unsigned>(_mm256_movemask_epi8(printable));
+            v = _mm256_blendv_epi8(_mm256_set1_epi8('N'), u, ok);
+        } else {
+            m = static_cast<unsigned>(_mm256_movemask_epi8(ok));
+        }
+        if (m == 0xFFFFFFFFu) {
+            // Common case inside a FASTA line: 32 output bytes, no compaction needed.
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), v);
+            n += 32;
+        } else if (m != 0) {
+            n += pack16(_mm256_castsi256_si128(v), m & 0xFFFFu, out + n);
+            n += pack16(_mm256_extracti128_si256(v, 1), m >> 16, out + n);
+        }
+    }
+    return n + clean_bases_sse42<KeepGaps>(in + k, len - k, out + n);
+}
+#endif
+
+using CleanFn = size_t (*)(const char*, size_t, char*);
+struct CleanKernel {
+    CleanFn fn;
+    CleanFn keep_gaps_fn;
+    const char* name;
+};
+
+CleanKernel select_clean_kernel() {
+    const char* forced = std::getenv("PLANNER_SIMD");
+    const std::string want = forced ? forced : "";
+#ifdef PLANNER_X86
+    __builtin_cpu_init();
+    const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    const bool has_sse42 = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    if (want != "scalar" && want != "sse42" && has_avx2) return {clean_bases_avx2<false>, clean_bases_avx2<true>, "avx2"};
+    if (want != "scalar" && has_sse42) return {clean_bases_sse42<false>, clean_bases_sse42<true>, "sse42"};
+#endif
+    return {clean_bases_scalar<false>, clean_bases_scalar<true>, "scalar"};
+}
+
+const CleanKernel& clean_kernel() {
+    static const CleanKernel kernel = select_clean_kernel();
+    return kernel;
+}
+
+} // namespace
+
+size_t clean_bases(const char* in, size_t len, char* out, bool keep_gaps) {
+    return keep_gaps ? clean_kernel().keep_gaps_fn(in, len, out) : clean_kernel().fn(in, len, out);
+}
+
+const char* clean_bases_kernel_name() {
+    return clean_kernel().name;
+}
+
+void append_clean_bases(const char* data, size_t len, std::string& out, bool keep_gaps) {
+    const size_t old = out.size();
+    out.resize(old + len);
+    out.resize(old + clean_bases(data, len, &out[old], keep_gaps));
+}
+
+std::vector<Segment> gap_free_segments(const std::string& seq) {
+    std::vector<Segment> segments;
+    const size_t n = seq.size();
+    size_t k = 0;
+    while (k < n) {
+        while (k < n && seq[k] == 'N') ++k;
+        const size_t start = k;
+        while (k < n && seq[k] != 'N') ++k;
+        if (k > start) segments.push_back({start, k});
+    }
+    return segments;
+}
+
+// --- FastaReader ---
+
+static constexpr size_t kReadChunk = size_t(1) << 22;
+
+FastaReader::FastaReader(const std::string& path, int threads, bool keep_gaps)
+    : src_(open_byte_source(path, threads)), keep_gaps_(keep_gaps) {
+    if (!src_) return;
+    buf_.resize(kReadChunk);
+    if (std::string(src_->kind()) == "plain") {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        file_size_ = ec ? 0 : static_cast<std::uint64_t>(size);
+    }
+    read_fai_lengths(path + ".fai", fai_lengths_);
+}
+
+bool FastaReader::fill() {
+    consumed_ += end_;
+    pos_ = 0;
+    end_ = src_->read(buf_.data(), buf_.size());
+    return end_ > 0;
+}
+
+bool FastaReader::next(FastaRecord& rec) {
+    for (;;) {
+        rec.header.clear();
+        rec.seq.clear();
+
+        // Skip to the next header: a '>' at the start of a line.
+        for (;;) {
+            if (pos_ == end_ && !fill()) return false;
+            if (at_line_start_ && buf_[pos_] == '>') {
+                ++pos_;
+                at_line_start_ = false;
+                break;
+            }
+            const char* nl = static_cast<const char*>(std::memchr(buf_.data() + pos_, '\n', end_ - pos_));
+            at_line_start_ = (nl != nullptr);
+            pos_ = nl ? static_cast<size_t>(nl - buf_.data()) + 1 : end_;
+        }
+
+        // Header runs to the end of its line.
+        for (;;) {
+            if (pos_ == end_ && !fill()) break;
+            const char* start = buf_.data() + pos_;
+            const char* nl = static_cast<const char*>(std::memchr(start, '\n', end_ - pos_));
+            if (!nl) {
+                rec.header.append(start, end_ - pos_);
+                pos_ = end_;
+                continue;
+            }
+            rec.header.append(start, static_cast<size_t>(nl - start));
+            pos_ = static_cast<size_t>(nl - buf_.data()) + 1;
+            at_line_start_ = true;
+            break;
+        }
+        if (!rec.header.empty() && rec.header.back() == '\r') rec.header.pop_back();
+
+        const auto fai = fai_lengths_.find(rec.header.substr(0, rec.header.find_first_of(" \t")));
+        if (fai != fai_lengths_.end()) {
+            rec.seq.reserve(static_cast<size_t>(fai->second));
+        } else if (file_size_ > consumed_ + pos_) {
+            // Without an index: up to the next header if it is in the buffer,
+            // else one read chunk, and the string grows from there.  The rest
+            // of the file would stay reserved in every record handed out.
+            size_t guess = static_cast<size_t>(std::min<std::uint64_t>(file_size_ - consumed_ - pos_, kReadChunk));
+            for (size_t p = pos_; p < end_;) {
+                const char* gt = static_cast<const char*>(std::memchr(buf_.data() + p, '>', end_ - p));
+                if (!gt) break;
+                const size_t at = static_cast<size_t>(gt - buf_.data());
+                if (at == pos_ ? at_line_start_ : buf_[at - 1] == '\n') {
+                    guess = at - pos_;
+                    break;
+                }
+                p = at + 1;
+            }
+            rec.seq.reserve(guess);
+        }
+
+        // Sequence runs up to the next '>' at the start of a line.
+        for (;;) {
+            if (pos_ == end_ && !fill()) break;
+            if (at_line_start_ && buf_[pos_] == '>') break;
+            size_t stop = end_;
+            for (size_t p = pos_; p < end_;) {
+                const char* gt = static_cast<const char*>(std::memchr(buf_.data() + p, '>', end_ - p));
+                if (!gt) break;
+                const size_t at = static_cast<size_t>(gt - buf_.data());
+                if (at > pos_ && buf_[at - 1] == '\n') {
+                    stop = at;
+                    break;
+                }
+                p = at + 1;
+            }
+            append_clean_bases(buf_.data() + pos_, stop - pos_, rec.seq, keep_gaps_);
+            at_line_start_ = (buf_[stop - 1] == '\n');
+            pos_ = stop;
+            if (stop < end_) break;
+        }
+        // Never hand out a record truncated by a decompression error.
+        if (src_->failed()) return false;
+        if (!rec.header.empty()) return true;
+    }
+}
+
+// --- PrefetchFastaReader ---
+
+PrefetchFastaReader::PrefetchFastaReader(const std::string& path, int threads, bool keep_gaps)
+    : reader_(path, threads, keep_gaps) {
+    if (reader_.is_open()) {
+        worker_ = std::thread([this] { run(); });
+    } else {
+        done_ = true;
+    }
+}
+
+PrefetchFastaReader::~PrefetchFastaReader() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void PrefetchFastaReader::run() {
+    FastaRecord rec;
+    for (;;) {
+        const bool ok = reader_.next(rec);
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return !slot_full_ || stopping_; });
+        if (stopping_) return;
+        if (!ok) {
+            done_ = true;
+            cv_.notify_all();
+            return;
+        }
+        // Swap rather than move so the caller's previous buffers get recycled.
+        slot_.header.swap(rec.header);
+        slot_.seq.swap(rec.seq);
+        slot_full_ = true;
+        cv_.notify_all();
+    }
+}
+
+bool PrefetchFastaReader::next(FastaRecord& rec) {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return slot_full_ || done_; });
+    if (!slot_full_) return false;
+    rec.header.swap(slot_.header);
+    rec.seq.swap(slot_.seq);
+    slot_full_ = false;
+    cv_.notify_all();
+    return true;
+}
+
+// --- Helpers ---
+
+std::map<std::string, std::string> read_fasta_and_clean(const std::string& path) {
+    std::map<std::string, std::string> sequences;
+    FastaReader reader(path);
+    if (!reader.is_open()) {
+        std::cerr << "ERROR: Could not open FASTA file: " << path << std::endl;
+        exit(1);
+    }
+    FastaRecord rec;
+    while (reader.next(rec)) {
+        sequences[rec.header] = rec.seq;
+    }
+    if (reader.failed()) exit(1);
+    return sequences;
+}
+
+// --- Random access ---
+
+bool read_fai(const std::string& fai_path, std::vector<FaiEntry>& entries) {
+    std::ifstream fai(fai_path);
+    if (!fai.is_open()) return false;
+    std::string line;
+    while (std::getline(fai, line)) {
+        std::istringstream fields(line);
+        FaiEntry e;
+        if (std::getline(fields, e.name, '\t') && (fields >> e.length >> e.offset >> e.line_bases >> e.line_width)) {
+            entries.push_back(std::move(e));
+        }
+    }
+    return true;
+}
+
+bool read_fai_lengths(const std::string& fai_path, std::map<std::string, std::uint64_t>& lengths) {
+    std::vector<FaiEntry> entries;
+    if (!read_fai(fai_path, entries)) return false;
+    for (const FaiEntry& e : entries) lengths[e.name] = e.length;
+    return true;
+}
+
+static bool parse_u64(const std::string& s, std::uint64_t& out) {
+    if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos) return false;
+    out = std::stoull(s);
+    return true;
+}
+
+bool parse_regions(const std::string& spec, std::vector<Region>& regions) {
+    std::ifstream bed(spec);
+    if (bed.is_open()) {
+        std::string line;
+        size_t line_no = 0;
+        while (std::getline(bed, line)) {
+            ++line_no;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#' || line.rfind("track", 0) == 0 || line.rfind("browser", 0) == 0) continue;
+            std::istringstream fields(line);
+            Region r;
+            std::string start, end;
+            fields >> r.chrom >> start >> end >> r.name;
+            if (!parse_u64(start, r.start) || !parse_u64(end, r.end) || r.end <= r.start) {
+                std::cerr << "ERROR: Malformed BED line " << line_no << " in " << spec << std::endl;
+                return false;
+            }
+            regions.push_back(std::move(r));
+        }
+        return true;
+    }
+
+    std::stringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (item.empty()) continue;
+        Region r;
+        r.chrom = item;
+        // Record names may themselves contain ':', so only split off a trailing
+        // "start-end" that parses as two numbers.
+        const size_t colon = item.rfind(':');
+        if (colon != std::string::npos) {
+            const std::string range = item.substr(colon + 1);
+            const size_t dash = range.find('-');
+            std::uint64_t first = 0, last = 0;
+            if (dash != std::string::npos && parse_u64(range.substr(0, dash), first) && parse_u64(range.substr(dash + 1), last)) {
+                if (first == 0 || last < first) {
+                    std::cerr << "ERROR: Malformed region '" << item << "' (expected chrom:start-end, 1-based)" << std::endl;
+                    return false;
+                }
+                r.chrom = item.substr(0, colon);
+                r.start = first - 1;
+                r.end = last;
+            }
+        }
+        regions.push_back(std::move(r));
+    }
+    return true;
+}
+
+IndexedFasta::~IndexedFasta() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+bool IndexedFasta::open(const std::string& path) {
+    std::vector<FaiEntry> entries;
+    if (!read_fai(path + ".fai", entries)) {
+        std::cerr << "ERROR: Region queries need " << path << ".fai (create it with: samtools faidx " << path << ")" << std::endl;
+        return false;
+    }
+    for (FaiEntry& e : entries) {
+        if (e.line_bases == 0 || e.line_width < e.line_bases) continue;
+        entries_[e.name] = std::move(e);
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Could not open FASTA file: " << path << std::endl;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        std::cerr << "ERROR: Could not stat FASTA file: " << path << std::endl;
+        return false;
+    }
+    unsigned char magic[2] = {0, 0};
+    if (pread(fd, magic, 2, 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        ::close(fd);
+        std::cerr << "ERROR: Region queries need an uncompressed FASTA: " << path << std::endl;
+        return false;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map FASTA file: " << path << std::endl;
+        return false;
+    }
+    data_ = static_cast<const char*>(p);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+const FaiEntry* IndexedFasta::find(const std::string& chrom) const {
+    auto it = entries_.find(chrom);
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+bool IndexedFasta::fetch(const Region& region, std::string& out, bool keep_gaps) const {
+    out.clear();
+    const FaiEntry* e = find(region.chrom);
+    if (!e) {
+        std::cerr << "ERROR: Record '" << region.chrom << "' is not in the .fai index" << std::endl;
+        return false;
+    }
+    const std::uint64_t end = (region.end == 0) ? e->length : std::min(region.end, e->length);
+    if (region.start >= end) {
+        std::cerr << "ERROR: Region " << region.chrom << ":" << region.start + 1 << "-" << region.end
+                  << " is outside the record (length " << e->length << ")" << std::endl;
+        return false;
+    }
+    // Base p of the record lives at offset + (p / line_bases) * line_width + p % line_bases.
+    auto byte_of = [e](std::uint64_t p) { return e->offset + (p / e->line_bases) * e->line_width + p % e->line_bases; };
+    const std::uint64_t b0 = byte_of(region.start);
+    const std::uint64_t b1 = byte_of(end - 1) + 1;
+    if (b1 > size_) {
+        std::cerr << "ERROR: .fai entry for '" << region.chrom << "' points past the end of the file" << std::endl;
+        return false;
+    }
+    append_clean_bases(data_ + b0, static_cast<size_t>(b1 - b0), out, keep_gaps);
+    return true;
+}
+
+std::string sanitize_header(std::string header) {
+    for (char& c : header) {
+        if (c == ' ' || c == ',') c = '_';
+    }
+    return header;
+}
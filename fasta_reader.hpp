@@ -0,0 +1,165 @@
+#pragma once
+// Target source: record-at-a-time FASTA reading with ACGT cleaning.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "byte_source.hpp"
+
+struct FastaRecord {
+    std::string header;   // header line without the leading '>'
+    std::string seq;      // cleaned sequence (upper-case A/C/G/T, plus N with keep_gaps)
+};
+
+// Streams records in file order from plain, gzip or BGZF input (see
+// open_byte_source; `threads` sizes the BGZF inflate pool).  Only the record being returned is held in
+// memory; reusing the same FastaRecord across calls also reuses its buffers.
+// Sequence lines before the first header, and records with an empty header,
+// are skipped.
+//
+// The file is read in large chunks and everything between two headers is
+// handed to clean_bases() in one call (newlines are dropped like any other
+// non-ACGT byte).  Each record's buffer is reserved up front: exactly from
+// <path>.fai when present, otherwise up to the next header if it is already
+// in the read buffer, else one read chunk (4 MiB), and it grows from there.
+// With keep_gaps, N and IUPAC codes are kept as 'N' so the cleaned sequence
+// keeps the record's coordinates (see clean_bases).
+class FastaReader {
+public:
+    explicit FastaReader(const std::string& path, int threads = 0, bool keep_gaps = false);
+    bool is_open() const { return src_ != nullptr; }
+    // True if reading stopped early because the input was corrupt.
+    bool failed() const { return src_ && src_->failed(); }
+    bool next(FastaRecord& rec);
+
+private:
+    bool fill();
+
+    std::unique_ptr<ByteSource> src_;
+    std::vector<char> buf_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    std::uint64_t file_size_ = 0;
+    std::uint64_t consumed_ = 0;   // file offset of buf_[0]
+    bool at_line_start_ = true;    // buf_[pos_] starts a line
+    bool keep_gaps_ = false;
+    std::map<std::string, std::uint64_t> fai_lengths_;
+};
+
+// FastaReader running on a background thread so the next record is read and
+// cleaned while the caller plans the current one.  At most two records are
+// held ahead of the caller's.
+class PrefetchFastaReader {
+public:
+    explicit PrefetchFastaReader(const std::string& path, int threads = 0, bool keep_gaps = false);
+    ~PrefetchFastaReader();
+    PrefetchFastaReader(const PrefetchFastaReader&) = delete;
+    PrefetchFastaReader& operator=(const PrefetchFastaReader&) = delete;
+
+    bool is_open() const { return reader_.is_open(); }
+    // Only meaningful once next() has returned false.
+    bool failed() const { return reader_.failed(); }
+    bool next(FastaRecord& rec);
+
+private:
+    void run();
+
+    FastaReader reader_;
+    std::thread worker_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    FastaRecord slot_;
+    bool slot_full_ = false;
+    bool done_ = false;
+    bool stopping_ = false;
+};
+
+// Reads a whole file at once, keyed (and therefore ordered) by header.
+// Prefer FastaReader for large targets.
+std::map<std::string, std::string> read_fasta_and_clean(const std::string& path);
+
+// Writes the upper-cased A/C/G/T characters of [in, in + len) to out and
+// returns how many were written; every other byte is dropped.  With
+// keep_gaps, whitespace and control bytes are still dropped but every other
+// non-ACGT byte (N, IUPAC codes such as R/Y, '-') is written as 'N', so
+// positions in out match positions in the record.  out must have room for
+// len bytes.  Uses AVX2 or SSE4.2 when the CPU supports them (selected once
+// at startup; PLANNER_SIMD=avx2|sse42|scalar overrides the choice).
+size_t clean_bases(const char* in, size_t len, char* out, bool keep_gaps = false);
+const char* clean_bases_kernel_name();
+
+// Appends clean_bases(data, len, ..., keep_gaps) to out.
+void append_clean_bases(const char* data, size_t len, std::string& out, bool keep_gaps = false);
+
+// A half-open interval [start, end) of a cleaned sequence.
+struct Segment {
+    size_t start = 0;
+    size_t end = 0;
+};
+
+// Maximal runs of A/C/G/T in a sequence cleaned with keep_gaps, in order.
+// N runs are never part of a segment, so each segment can be planned on its
+// own without a block straddling a gap.
+std::vector<Segment> gap_free_segments(const std::string& seq);
+
+// --- RANDOM ACCESS ---
+
+// One line of a samtools .fai index.
+struct FaiEntry {
+    std::string name;            // first word of the header
+    std::uint64_t length = 0;    // bases in the record
+    std::uint64_t offset = 0;    // file offset of the first base
+    std::uint64_t line_bases = 0;
+    std::uint64_t line_width = 0;  // line_bases plus the line terminator
+};
+
+// Returns false when the file cannot be read; malformed lines are skipped.
+bool read_fai(const std::string& fai_path, std::vector<FaiEntry>& entries);
+// Sequence lengths by record name, from read_fai.
+bool read_fai_lengths(const std::string& fai_path, std::map<std::string, std::uint64_t>& lengths);
+
+// A target interval [start, end) in 0-based record coordinates.
+struct Region {
+    std::string chrom;
+    std::uint64_t start = 0;
+    std::uint64_t end = 0;       // 0 = to the end of the record
+    std::string name;            // label used in the output
+};
+
+// Parses a region list.  spec is either a BED file (chrom, start, end and an
+// optional name column) or a comma-separated list of samtools-style regions:
+// "chr4" or "chr4:100001-300000" (1-based, inclusive).  Prints an error and
+// returns false on malformed input.
+bool parse_regions(const std::string& spec, std::vector<Region>& regions);
+
+// Uncompressed FASTA mapped into memory and addressed through its .fai, so a
+// region costs only the pages it covers.  fetch() is safe to call from
+// several threads at once.
+class IndexedFasta {
+public:
+    IndexedFasta() = default;
+    ~IndexedFasta();
+    IndexedFasta(const IndexedFasta&) = delete;
+    IndexedFasta& operator=(const IndexedFasta&) = delete;
+
+    // Needs <path>.fai (samtools faidx).  Prints an error and returns false on failure.
+    bool open(const std::string& path);
+    const FaiEntry* find(const std::string& chrom) const;
+    // Cleans the bases of region (end clipped to the record length) into out;
+    // keep_gaps as for clean_bases.  Prints an error and returns false if the
+    // region does not fit the record.
+    bool fetch(const Region& region, std::string& out, bool keep_gaps = false) const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::map<std::string, FaiEntry> entries_;
+};
+
+// Replace characters that would break the CSV output (spaces, commas).
+std::string sanitize_header(std::string header);
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <sstream>
+#include "planner_core.hpp"
+
+// --- MAIN PROGRAM ---
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--help") {
+        std::cout << "Usage: " << argv[0]
+                  << " <planners> [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <source_index.fm>\n\n"
+                  << "Runs several genome construction planners in one invocation.\n"
+                  << "The source index is loaded once and the reuse profile of each target\n"
+                  << "record is computed once, then shared by every selected planner.\n\n"
+                  << "Arguments:\n"
+                  << "  planners         Comma-separated list of planners, or 'all':\n"
+                  << "                     dp        optimal DP planner (genome_planner_flex)\n"
+                  << "                     greedy    Replication-First heuristic (greedy_planner_clean)\n"
+                  << "                     maxblock  Max-Block heuristic (max_block_greedy_clean)\n"
+                  << "  options, W ... source_index.fm\n"
+                  << "                   Same as genome_planner_flex (see its --help).\n\n"
+                  << "Output (CSV): planner, filename, chromosome, length_bp, total_cost\n"
+                  << "followed by one STATS_TOTAL,<planner>,... line and one TOTAL row per planner.\n"
+                  << "With a single planner the output is identical to the dedicated binary.\n\n"
+                  << "Example:\n"
+                  << "  ./genome_planner_multi all 1000 target.fasta 5 1.5 0.2 1e-4 source.fm\n"
+                  << std::endl;
+        return 0;
+    }
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <planners> [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <source_index.fm>"
+                  << "  (use --help for details)" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    const std::string planner_list = argv[1];
+    if (planner_list == "all") {
+        names = planner_names();
+    } else {
+        std::stringstream ss(planner_list);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            if (!name.empty()) names.push_back(name);
+        }
+    }
+
+    std::vector<std::unique_ptr<Planner>> owned;
+    std::vector<const Planner*> planners;
+    for (const std::string& name : names) {
+        std::unique_ptr<Planner> planner = make_planner(name);
+        if (!planner) {
+            std::cerr << "ERROR: Unknown planner '" << name << "' (expected dp, greedy, maxblock or all)" << std::endl;
+            return 1;
+        }
+        planners.push_back(planner.get());
+        owned.push_back(std::move(planner));
+    }
+    if (planners.empty()) {
+        std::cerr << "ERROR: No planner selected" << std::endl;
+        return 1;
+    }
+
+    PlannerArgs args;
+    if (!parse_planner_args(argc, argv, 2, args)) { return 1; }
+    return run_planners(args, planners);
+}
@@ -0,0 +1,163 @@
+#include "junction_motifs.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// --- MOTIF LISTS ---
+
+namespace {
+
+int base_code(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+bool normalise_motif(std::string& motif) {
+    for (char& c : motif) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return !motif.empty() && std::all_of(motif.begin(), motif.end(), [](char c) { return base_code(c) >= 0; });
+}
+
+std::string reverse_complement(const std::string& s) {
+    std::string rc(s.rbegin(), s.rend());
+    for (char& c : rc) c = "TGCA"[base_code(c)];
+    return rc;
+}
+
+} // namespace
+
+bool load_motifs(const std::string& path, std::vector<std::string>& motifs) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "ERROR: Could not open motif list: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        std::string field, motif;
+        while (fields >> field) motif = field;   // the last field; a name may precede it
+        if (motif.empty()) continue;
+        if (!normalise_motif(motif)) {
+            std::cerr << "ERROR: " << path << ":" << line_no << ": motif must be A/C/G/T only" << std::endl;
+            return false;
+        }
+        motifs.push_back(motif);
+    }
+    return true;
+}
+
+bool parse_motif_list(const std::string& text, std::vector<std::string>& motifs) {
+    std::stringstream ss(text);
+    std::string motif;
+    while (std::getline(ss, motif, ',')) {
+        if (!normalise_motif(motif)) return false;
+        motifs.push_back(motif);
+    }
+    return true;
+}
+
+// --- AHO-CORASICK ---
+
+namespace {
+
+// Automaton over ACGT with the failure links folded into the transitions.
+// longest[s] is the longest motif that is a suffix of state s's string.
+class MotifAutomaton {
+public:
+    explicit MotifAutomaton(const std::vector<std::string>& motifs) {
+        next_.push_back(kNone);
+        longest_.push_back(0);
+        for (const std::string& m : motifs) {
+            size_t s = 0;
+            for (const char c : m) {
+                const size_t b = static_cast<size_t>(base_code(c));
+                if (next_[s][b] == 0) {
+                    next_[s][b] = static_cast<std::uint32_t>(next_.size());
+                    next_.push_back(kNone);
+                    longest_.push_back(0);
+                }
+                s = next_[s][b];
+            }
+            longest_[s] = std::max<std::uint32_t>(longest_[s], static_cast<std::uint32_t>(m.size()));
+        }
+        // Breadth-first: a state's failure target is finished before it.
+        std::vector<std::uint32_t> fail(next_.size(), 0);
+        std::vector<std::uint32_t> queue;
+        for (const std::uint32_t child : next_[0]) {
+            if (child != 0) queue.push_back(child);
+        }
+        for (size_t q = 0; q < queue.size(); ++q) {
+            const std::uint32_t s = queue[q];
+            longest_[s] = std::max(longest_[s], longest_[fail[s]]);
+            for (size_t b = 0; b < 4; ++b) {
+                const std::uint32_t child = next_[s][b];
+                if (child != 0) {
+                    fail[child] = next_[fail[s]][b];
+                    queue.push_back(child);
+                } else {
+                    next_[s][b] = next_[fail[s]][b];
+                }
+            }
+        }
+    }
+
+    std::uint32_t step(std::uint32_t s, char c) const {
+        const int b = base_code(c);
+        return b < 0 ? 0 : next_[s][static_cast<size_t>(b)];
+    }
+    std::uint32_t longest(std::uint32_t s) const { return longest_[s]; }
+
+private:
+    static constexpr std::array<std::uint32_t, 4> kNone = {0, 0, 0, 0};
+    std::vector<std::array<std::uint32_t, 4>> next_;
+    std::vector<std::uint32_t> longest_;
+};
+
+} // namespace
+
+// --- BOUNDARY MASK ---
+
+BoundaryMask forbidden_boundaries(const std::string& seq, const std::vector<std::string>& motifs, int W) {
+    BoundaryMask mask;
+    if (motifs.empty()) return mask;
+    std::vector<std::string> both = motifs;
+    for (const std::string& m : motifs) both.push_back(reverse_complement(m));
+    const MotifAutomaton automaton(both);
+
+    const size_t N = seq.size();
+    mask.bits_.assign(N / 64 + 1, 0);
+    // An occurrence ending at e (exclusive) of length L blocks (e - L, e);
+    // the longest motif ending at e covers all shorter ones.
+    std::uint32_t state = 0;
+    for (size_t k = 0; k < N; ++k) {
+        state = automaton.step(state, seq[k]);
+        const size_t L = automaton.longest(state);
+        for (size_t b = k + 2 - L; b <= k; ++b) mask.set(b);
+    }
+
+    // Reopen the boundary W after the last open one wherever a run is too
+    // long to be spanned by one block.
+    size_t open = 0;
+    for (size_t k = 1; k < N; ++k) {
+        if (!mask.blocked(k)) {
+            open = k;
+        } else if (k - open == static_cast<size_t>(W)) {
+            mask.clear(k);
+            open = k;
+        }
+    }
+    return mask;
+}
@@ -0,0 +1,41 @@
+#pragma once
+// Forbidden block boundaries.
+//
+// A junction that falls inside a recognition site (BsaI GGTCTC, BsmBI
+// CGTCTC, ...) disrupts it, and the assembled scar may recreate it, either
+// of which ruins a Golden Gate assembly.  One Aho-Corasick pass over a record
+// finds every occurrence of the motifs and of their reverse complements and
+// marks the boundaries strictly inside each one, so the planners test a
+// boundary in O(1).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reads forbidden motifs: one per line, optionally preceded by a name
+// ("BsaI GGTCTC"), '#' comments.  Motifs are upper-cased ACGT.  Prints an
+// error and returns false on bad input.
+bool load_motifs(const std::string& path, std::vector<std::string>& motifs);
+// Parses a comma-separated motif list; false on an empty or non-ACGT motif.
+bool parse_motif_list(const std::string& text, std::vector<std::string>& motifs);
+
+// Boundary k separates seq[k-1] and seq[k]; 0 and N are never blocked.
+class BoundaryMask {
+public:
+    bool empty() const { return bits_.empty(); }
+    bool blocked(size_t k) const { return !bits_.empty() && ((bits_[k >> 6] >> (k & 63)) & 1u); }
+
+private:
+    friend BoundaryMask forbidden_boundaries(const std::string& seq, const std::vector<std::string>& motifs, int W);
+    void set(size_t k) { bits_[k >> 6] |= std::uint64_t(1) << (k & 63); }
+    void clear(size_t k) { bits_[k >> 6] &= ~(std::uint64_t(1) << (k & 63)); }
+
+    std::vector<std::uint64_t> bits_;
+};
+
+// Every boundary strictly inside an occurrence of a motif (either strand).
+// A block spans at most W bases, so a run of W or more blocked boundaries
+// cannot be avoided; in such runs every W-th boundary is reopened, the fewest
+// cuts that keep the record plannable.  Empty when motifs is.
+BoundaryMask forbidden_boundaries(const std::string& seq, const std::vector<std::string>& motifs, int W);
@@ -0,0 +1,2320 @@
+#include "planner_core.hpp"
+#include "dp_kernels.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
+#include <variant>
+
+namespace fs = std::filesystem;
+
+// --- STATS ---
+
+void PlannerStats::accumulate(const PlannerStats& other) {
+    cost += other.cost;
+    reuse_moves += other.reuse_moves;
+    synth_moves += other.synth_moves;
+    joins += other.joins;
+    segments += other.segments;
+    reuse_bases += other.reuse_bases;
+    synth_bases += other.synth_bases;
+    length += other.length;
+    mismatches += other.mismatches;
+    planned = planned && other.planned;
+}
+
+// --- INDEX HANDLE ---
+
+bool load_source_index(const std::string& index_path, SourceIndex& out) {
+    out.path = index_path;
+    out.indexes.clear();
+    out.colors.clear();
+    std::stringstream ss(index_path);
+    std::string path;
+    while (std::getline(ss, path, ',')) {
+        std::vector<text_index_t> loaded = load_single_index(path);
+        if (loaded.empty()) return false;
+        std::unique_ptr<DonorColors> colors;
+        if (fs::exists(donor_colors_path(path))) {
+            colors.reset(new DonorColors());
+            if (!colors->load(donor_colors_path(path)) || colors->size() != index_size(loaded.front())) {
+                std::cerr << "ERROR: Could not load donor colours: " << donor_colors_path(path) << std::endl;
+                return false;
+            }
+        }
+        out.indexes.push_back(std::move(loaded.front()));
+        out.colors.push_back(std::move(colors));
+    }
+    return !out.indexes.empty();
+}
+
+size_t SourceIndex::donors() const {
+    size_t n = 0;
+    for (const auto& c : colors) n += c ? c->donors() : 1;
+    return n;
+}
+
+std::vector<std::string> SourceIndex::donor_names() const {
+    std::vector<std::string> names;
+    std::stringstream ss(path);
+    std::string file;
+    for (size_t s = 0; s < indexes.size() && std::getline(ss, file, ','); ++s) {
+        if (!colors[s]) {
+            names.push_back(fs::path(file).filename().string());
+            continue;
+        }
+        for (const std::string& name : colors[s]->names()) names.push_back(name);
+    }
+    return names;
+}
+
+std::vector<text_index_t> load_single_index(const std::string& index_path) {
+    std::vector<text_index_t> indexes;
+    if (RIndex::is_r_index(index_path)) {
+        RIndex index;
+        if (index.load(index_path)) {
+            indexes.emplace_back(std::move(index));
+        } else {
+            std::cerr << "ERROR: Could not load r-index file: " << index_path << std::endl;
+        }
+        return indexes;
+    }
+    fm_index_t index;
+    if (sdsl::load_from_file(index, index_path)) {
+        indexes.emplace_back(std::move(index));
+    } else {
+        std::cerr << "ERROR: Could not load index file: " << index_path << std::endl;
+    }
+    return indexes;
+}
+
+std::uint64_t index_size(const text_index_t& index) {
+    return std::visit([](const auto& backend) { return static_cast<std::uint64_t>(backend.size()); }, index);
+}
+
+bool query_kmer(const std::string& kmer, const std::vector<text_index_t>& indexes) {
+    for (const auto& index : indexes) {
+        if (const fm_index_t* fm = std::get_if<fm_index_t>(&index)) {
+            if (sdsl::count(*fm, kmer.begin(), kmer.end()) > 0) return true;
+        } else if (std::get<RIndex>(index).count(kmer) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- COST MODEL ---
+
+double cost_synth(int length, double cost_per_base) {
+    return static_cast<double>(length) * cost_per_base;
+}
+
+double cost_synth_nonlinear(int length, double linear_per_base, double quad_coeff) {
+    const double x = static_cast<double>(length);
+    return (linear_per_base * x) + (quad_coeff * x * x);
+}
+
+bool load_synth_table(const std::string& path, std::vector<double>& table) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "ERROR: Could not open synthesis price table: " << path << std::endl;
+        return false;
+    }
+    table.assign(1, 0.0);
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        long long length = 0;
+        double cost = 0.0;
+        if (!(fields >> length)) continue;   // blank or comment line
+        if (!(fields >> cost) || length < static_cast<long long>(table.size()) || length > kMaxBlockLen) {
+            std::cerr << "ERROR: " << path << ":" << line_no
+                      << ": expected '<length> <cost>' with lengths increasing and at most " << kMaxBlockLen << std::endl;
+            return false;
+        }
+        table.resize(static_cast<size_t>(length) + 1, cost);
+    }
+    if (table.size() < 2) {
+        std::cerr << "ERROR: Synthesis price table " << path << " has no rows" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --- REUSE PROFILE ---
+
+// One backward-search step on either backend: the interval [l2, r2] of c P
+// from [l, r] of P, returning its width.
+static inline std::uint64_t backward_step(const fm_index_t& index, fm_index_t::size_type l, fm_index_t::size_type r,
+                                          fm_index_t::char_type c, fm_index_t::size_type& l2, fm_index_t::size_type& r2) {
+    return sdsl::backward_search(index, l, r, c, l2, r2);
+}
+
+static inline std::uint64_t backward_step(const RIndex& index, RIndex::size_type l, RIndex::size_type r, RIndex::char_type c,
+                                          RIndex::size_type& l2, RIndex::size_type& r2) {
+    return index.backward_search(l, r, c, l2, r2);
+}
+
+// Longest reusable suffix of seq[0, i) for every i, against one index.
+// Once no match exists for length w, longer strings (w+1,...) also cannot match,
+// so each position stops at its first failing extension.  Matches shorter
+// than min_len are not recorded, and when seq[i-w-1, i) has no match with
+// w < min_len, no window of min_len bases containing it can match either,
+// so the next min_len - w - 1 end positions are skipped.
+// With multi_len, the longest suffix occurring more than once in this index
+// is read off the interval widths (occ >= 2); repeats across indexes are
+// left to the merge.  end_len and multi_len start out zero.
+// With tiers (a panel index), tier_len[t][i] is the longest match whose
+// interval holds a donor of tier t or cheaper.  The cheapest tier of an
+// interval only rises as it narrows, so it is queried once per extension,
+// and no more once the interval is a single suffix or the dearest tier.
+template <typename Index>
+static void max_reuse_ends_for_index(const std::string& seq, int W, const Index& index, std::vector<std::uint16_t>& end_len,
+                                     int min_len, std::vector<std::uint16_t>* multi_len, const DonorTiers* tiers = nullptr,
+                                     std::vector<std::vector<std::uint16_t>>* tier_len = nullptr) {
+    const int T = tier_len ? static_cast<int>(tier_len->size()) : 0;
+    auto record_tiers = [&](long long i, int from, int to, int w) {
+        if (w < min_len) return;
+        for (int t = from; t < to; ++t) (*tier_len)[static_cast<size_t>(t)][static_cast<size_t>(i)] = static_cast<std::uint16_t>(w);
+    };
+    const long long N = static_cast<long long>(seq.length());
+    for (long long i = 1; i <= N;) {
+        const int max_w = static_cast<int>(std::min<long long>(W, i));
+        // Interval for empty pattern is the full suffix array range.
+        typename Index::size_type l = 0;
+        typename Index::size_type r = index.size() - 1;
+        int w = 0;
+        int repeated_w = 0;
+        bool failed = false;
+        int cheapest = -1;   // cheapest tier of the current interval
+        bool settled = false;   // a single suffix: the tier is final
+        while (w < max_w) {
+            const char c = seq[static_cast<size_t>(i - w - 1)];
+            typename Index::size_type l2 = 0, r2 = 0;
+            const auto occ = backward_step(index, l, r, static_cast<typename Index::char_type>(c), l2, r2);
+            if (occ == 0) {
+                failed = true;
+                break;
+            }
+            l = l2;
+            r = r2;
+            ++w;
+            if (occ > 1) repeated_w = w;
+            if (tiers && cheapest < T - 1 && !settled) {
+                const int m = (occ == 1) ? tiers->tier(l) : tiers->cheapest(l, r);
+                if (cheapest >= 0) record_tiers(i, cheapest, m, w - 1);
+                cheapest = m;
+                settled = occ == 1;
+            }
+        }
+        if (cheapest >= 0) record_tiers(i, cheapest, T, w);
+        if (multi_len) (*multi_len)[static_cast<size_t>(i)] = static_cast<std::uint16_t>(repeated_w);
+        if (w >= min_len) end_len[static_cast<size_t>(i)] = static_cast<std::uint16_t>(w);
+        i += (failed && w < min_len) ? min_len - w : 1;
+    }
+}
+
+// Longest suffixes of seq[0, i) within d = 1..k substitutions of a string of
+// one index, by backtracking over the backward search: at every depth the
+// pattern base is tried first, then, while mismatches remain, the other three
+// bases.  Depth-first, so the exact path is followed to its end first and the
+// mismatches nearest to it are tried next.  A branch stops on an empty
+// interval, and the whole search stops once no mismatch budget left to the
+// branch can still improve: best[d] at i is at most best[d] at i - 1 plus one
+// (drop the last base of the match), so once every reachable best[d] meets
+// that bound nothing is left to find.  In a region matching the source this
+// follows the exact path and one substitution branch per mismatch.  Lengths
+// below min_len are recorded as 0, and as in max_reuse_ends_for_index, when
+// not even k substitutions reach min_len bases, no min_len-bp window over
+// that stretch can be within k either, so the search skips ahead (and has no
+// bound at the next position it searches).
+template <typename Index>
+static void approx_reuse_ends_for_index(const std::string& seq, int W, const Index& index, int min_len,
+                                        std::vector<std::vector<std::uint16_t>>& approx_len) {
+    const int k = static_cast<int>(approx_len.size());
+    const long long N = static_cast<long long>(seq.length());
+    static const char kBases[4] = {'A', 'C', 'G', 'T'};
+    struct Frame {
+        typename Index::size_type l, r;
+        int mismatches;
+        int next;   // next option: 0 = the pattern base, 1..4 = substitutions
+    };
+    // Positions are independent but for the bound, so chunks of the record
+    // are searched in parallel, each starting without one.
+    constexpr long long kChunk = 1 << 16;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long from = 1; from <= N; from += kChunk) {
+        const long long to = std::min(N, from + kChunk - 1);
+        std::vector<Frame> stack(static_cast<size_t>(W) + 1);
+        std::vector<int> best(static_cast<size_t>(k) + 1), bound(static_cast<size_t>(k) + 1), prev(static_cast<size_t>(k) + 1, W);
+        for (long long i = from; i <= to;) {
+            const int max_w = static_cast<int>(std::min<long long>(W, i));
+            for (int d = 0; d <= k; ++d) {
+                best[static_cast<size_t>(d)] = 0;
+                bound[static_cast<size_t>(d)] = std::min(max_w, prev[static_cast<size_t>(d)] + 1);
+            }
+            // Whether a branch with m mismatches can still raise some best[d].
+            auto open = [&](int m) {
+                for (int d = m; d <= k; ++d) {
+                    if (best[static_cast<size_t>(d)] < bound[static_cast<size_t>(d)]) return true;
+                }
+                return false;
+            };
+            int depth = 0;
+            stack[0] = {0, index.size() - 1, 0, 0};
+            while (depth >= 0) {
+                Frame& f = stack[static_cast<size_t>(depth)];
+                if (depth == max_w || f.next > 4 || !open(f.mismatches)) {
+                    --depth;
+                    continue;
+                }
+                const char base = seq[static_cast<size_t>(i - depth - 1)];
+                const int option = f.next++;
+                char c = base;
+                int m = f.mismatches;
+                if (option > 0) {
+                    c = kBases[option - 1];
+                    if (c == base) continue;
+                    if (++m > k) {
+                        f.next = 5;
+                        continue;
+                    }
+                }
+                typename Index::size_type l2 = 0, r2 = 0;
+                if (backward_step(index, f.l, f.r, static_cast<typename Index::char_type>(c), l2, r2) == 0) continue;
+                ++depth;
+                stack[static_cast<size_t>(depth)] = {l2, r2, m, 0};
+                for (int d = m; d <= k; ++d) best[static_cast<size_t>(d)] = std::max(best[static_cast<size_t>(d)], depth);
+            }
+            for (int d = 1; d <= k; ++d) {
+                const int w = best[static_cast<size_t>(d)];
+                std::uint16_t& slot = approx_len[static_cast<size_t>(d - 1)][static_cast<size_t>(i)];
+                if (w >= min_len && w > slot) slot = static_cast<std::uint16_t>(w);
+            }
+            const int reached = best[static_cast<size_t>(k)];
+            if (reached < min_len && reached < max_w) {
+                std::fill(prev.begin(), prev.end(), W);
+                i += min_len - reached;
+            } else {
+                prev = best;
+                ++i;
+            }
+        }
+    }
+}
+
+// The searches above on the backend the index was loaded with.
+static void max_reuse_ends_for_source(const std::string& seq, int W, const text_index_t& index, std::vector<std::uint16_t>& end_len,
+                                      int min_len, std::vector<std::uint16_t>* multi_len, const DonorTiers* tiers = nullptr,
+                                      std::vector<std::vector<std::uint16_t>>* tier_len = nullptr) {
+    std::visit([&](const auto& backend) {
+        max_reuse_ends_for_index(seq, W, backend, end_len, min_len, multi_len, tiers, tier_len);
+    }, index);
+}
+
+static void approx_reuse_ends_for_source(const std::string& seq, int W, const text_index_t& index, int min_len,
+                                         std::vector<std::vector<std::uint16_t>>& approx_len) {
+    std::visit([&](const auto& backend) { approx_reuse_ends_for_index(seq, W, backend, min_len, approx_len); }, index);
+}
+
+ReuseProfile compute_reuse_profile(const std::string& seq, int W, const std::vector<text_index_t>& indexes,
+                                   int min_len, int max_len, bool occurrences, bool self,
+                                   int mismatches, const std::vector<double>& source_pcr,
+                                   const std::vector<const DonorColors*>& colors) {
+    ReuseProfile profile;
+    const size_t N = seq.length();
+    profile.W = W;
+    profile.end_len.assign(N + 1, 0);
+    profile.start_len.assign(N + 1, 0);
+    if (occurrences) profile.multi_len.assign(N + 1, 0);
+
+    const int search_len = (max_len > 0) ? std::min(W, max_len) : W;
+    const size_t S = indexes.size();
+    if (S == 1 && source_pcr.empty()) {
+        max_reuse_ends_for_source(seq, search_len, indexes.front(), profile.end_len, std::max(1, min_len),
+                                 occurrences ? &profile.multi_len : nullptr);
+    } else {
+        // A donor panel: every index is searched on its own, in parallel,
+        // then merged.  A block repeats if it repeats within one index or
+        // occurs in two (the shorter match).  Donors are numbered in load
+        // order, every colour of a panel index in turn, and ranked into
+        // price tiers.
+        std::vector<std::uint16_t> tier_of;   // by donor
+        if (!source_pcr.empty()) {
+            profile.tier_pcr = source_pcr;
+            std::sort(profile.tier_pcr.begin(), profile.tier_pcr.end());
+            profile.tier_pcr.erase(std::unique(profile.tier_pcr.begin(), profile.tier_pcr.end()), profile.tier_pcr.end());
+            for (const double p : source_pcr) {
+                tier_of.push_back(static_cast<std::uint16_t>(
+                    std::lower_bound(profile.tier_pcr.begin(), profile.tier_pcr.end(), p) - profile.tier_pcr.begin()));
+            }
+        }
+        const size_t T = profile.tier_pcr.size();
+        auto colors_of = [&colors](size_t s) { return s < colors.size() ? colors[s] : nullptr; };
+        std::vector<size_t> first_donor(S + 1, 0);
+        for (size_t s = 0; s < S; ++s) {
+            first_donor[s + 1] = first_donor[s] + (colors_of(s) ? colors_of(s)->donors() : 1);
+        }
+        std::vector<const DonorTiers*> donor_tiers;
+        for (size_t s = 0; s < S; ++s) {
+            donor_tiers.push_back(nullptr);
+            if (T == 0 || !colors_of(s)) continue;
+            std::vector<std::uint16_t> ranking;
+            for (size_t d = first_donor[s]; d < first_donor[s + 1]; ++d) ranking.push_back(tier_of[d]);
+            donor_tiers.back() = &colors_of(s)->tiers(ranking);
+        }
+        std::vector<std::vector<std::uint16_t>> ends(S), repeats(occurrences ? S : 0);
+        std::vector<std::vector<std::vector<std::uint16_t>>> panel_tiers(S);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long s = 0; s < static_cast<long long>(S); ++s) {
+            const size_t k = static_cast<size_t>(s);
+            ends[k].assign(N + 1, 0);
+            if (occurrences) repeats[k].assign(N + 1, 0);
+            const DonorTiers* tiers = donor_tiers[k];
+            if (tiers) panel_tiers[k].assign(T, std::vector<std::uint16_t>(N + 1, 0));
+            max_reuse_ends_for_source(seq, search_len, indexes[k], ends[k], std::max(1, min_len),
+                                     occurrences ? &repeats[k] : nullptr, tiers, tiers ? &panel_tiers[k] : nullptr);
+        }
+        if (T > 0) profile.tier_len.assign(T, std::vector<std::uint16_t>(N + 1, 0));
+        for (size_t s = 0; s < S; ++s) {
+            for (size_t i = 1; i <= N; ++i) {
+                if (occurrences) {
+                    const std::uint16_t across = std::min(ends[s][i], profile.end_len[i]);
+                    profile.multi_len[i] = std::max({profile.multi_len[i], repeats[s][i], across});
+                }
+                profile.end_len[i] = std::max(profile.end_len[i], ends[s][i]);
+            }
+            if (T == 0) continue;
+            for (size_t t = 0; t < T; ++t) {
+                if (panel_tiers[s].empty() && t != tier_of[first_donor[s]]) continue;
+                const std::vector<std::uint16_t>& len = panel_tiers[s].empty() ? ends[s] : panel_tiers[s][t];
+                for (size_t i = 1; i <= N; ++i) profile.tier_len[t][i] = std::max(profile.tier_len[t][i], len[i]);
+            }
+        }
+        // A donor of tier t also serves every dearer tier.
+        for (size_t t = 1; t < T; ++t) {
+            for (size_t i = 1; i <= N; ++i) profile.tier_len[t][i] = std::max(profile.tier_len[t][i], profile.tier_len[t - 1][i]);
+        }
+    }
+    if (self) add_self_reuse(seq, search_len, std::max(1, min_len), profile.end_len, occurrences ? &profile.multi_len : nullptr);
+    if (mismatches > 0) {
+        profile.approx_len.assign(static_cast<size_t>(mismatches), std::vector<std::uint16_t>(N + 1, 0));
+        for (const auto& index : indexes) approx_reuse_ends_for_source(seq, search_len, index, std::max(1, min_len), profile.approx_len);
+    }
+
+    // A reusable block [s, e) is either the longest one ending at e (s = e - end_len[e]),
+    // or [s-1, e) is reusable too, in which case start_len[s] >= start_len[s-1] - 1.
+    for (size_t e = 1; e <= N; ++e) {
+        const std::uint16_t L = profile.end_len[e];
+        if (L > 0) {
+            std::uint16_t& slot = profile.start_len[e - L];
+            if (L > slot) slot = L;
+        }
+    }
+    for (size_t s = 1; s < N; ++s) {
+        const std::uint16_t carried = profile.start_len[s - 1] > 0 ? static_cast<std::uint16_t>(profile.start_len[s - 1] - 1) : 0;
+        if (carried > profile.start_len[s]) profile.start_len[s] = carried;
+    }
+    return profile;
+}
+
+std::vector<std::vector<std::vector<std::uint16_t>>> donor_reuse_ends(const std::vector<std::string>& seqs, int W,
+                                                                      const SourceIndex& source, int min_len,
+                                                                      int max_len) {
+    const int search_len = (max_len > 0) ? std::min(W, max_len) : W;
+    // One job per donor: (index, colour or -1 for a plain index).
+    std::vector<std::pair<size_t, long long>> jobs;
+    for (size_t s = 0; s < source.indexes.size(); ++s) {
+        const DonorColors* colors = s < source.colors.size() ? source.colors[s].get() : nullptr;
+        if (!colors) {
+            jobs.emplace_back(s, -1);
+            continue;
+        }
+        for (size_t d = 0; d < colors->donors(); ++d) jobs.emplace_back(s, static_cast<long long>(d));
+    }
+    std::vector<std::vector<std::vector<std::uint16_t>>> ends(jobs.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long j = 0; j < static_cast<long long>(jobs.size()); ++j) {
+        const size_t s = jobs[static_cast<size_t>(j)].first;
+        const long long color = jobs[static_cast<size_t>(j)].second;
+        std::unique_ptr<DonorTiers> tiers;
+        if (color >= 0) {
+            std::vector<std::uint16_t> tier_of(source.colors[s]->donors(), 1);
+            tier_of[static_cast<size_t>(color)] = 0;
+            tiers.reset(new DonorTiers(*source.colors[s], std::move(tier_of)));
+        }
+        std::vector<std::vector<std::uint16_t>>& out = ends[static_cast<size_t>(j)];
+        for (const std::string& seq : seqs) {
+            std::vector<std::uint16_t> end_len(seq.length() + 1, 0);
+            if (!tiers) {
+                max_reuse_ends_for_source(seq, search_len, source.indexes[s], end_len, std::max(1, min_len), nullptr);
+                out.push_back(std::move(end_len));
+                continue;
+            }
+            std::vector<std::vector<std::uint16_t>> tier_len(2, std::vector<std::uint16_t>(seq.length() + 1, 0));
+            max_reuse_ends_for_source(seq, search_len, source.indexes[s], end_len, std::max(1, min_len), nullptr,
+                                     tiers.get(), &tier_len);
+            out.push_back(std::move(tier_len[0]));
+        }
+    }
+    return ends;
+}
+
+// --- CIRCULAR RECORDS ---
+
+// The plan starts at a cut in [0, W) and ends N bases later; a fragment
+// reaches W bases before its block, a primer site or a motif around a cut
+// max(P, longest motif) bases past it.
+long long circular_margin(const CostModel& costs, int W) {
+    size_t motif = 0;
+    for (const std::string& m : costs.forbidden_motifs) motif = std::max(motif, m.size());
+    return static_cast<long long>(W) + std::max<long long>(costs.primer.length, static_cast<long long>(motif));
+}
+
+std::string circular_extension(const std::string& seq, long long margin) {
+    const long long N = static_cast<long long>(seq.size());
+    if (N == 0) return std::string();
+    std::string text(static_cast<size_t>(N + 2 * margin), 'A');
+    for (long long k = 0; k < N + 2 * margin; ++k) {
+        text[static_cast<size_t>(k)] = seq[static_cast<size_t>(((k - margin) % N + N) % N)];
+    }
+    return text;
+}
+
+ReuseProfile compute_plan_profile(const std::string& seq, int W, const SourceIndex& source, const CostModel& costs) {
+    std::vector<const DonorColors*> colors;
+    for (const auto& c : source.colors) colors.push_back(c.get());
+    if (!costs.circular || seq.empty()) {
+        return compute_reuse_profile(seq, W, source.indexes, costs.reuse_min, costs.reuse_max, costs.counts_occurrences(),
+                                     costs.self_reuse, costs.max_mismatches, costs.source_pcr, colors);
+    }
+    return compute_reuse_profile(circular_extension(seq, circular_margin(costs, W)), W, source.indexes, costs.reuse_min,
+                                 costs.reuse_max, costs.counts_occurrences(), false, costs.max_mismatches, costs.source_pcr,
+                                 colors);
+}
+
+// --- PLANNERS ---
+
+namespace {
+
+// --- DP COST POLICIES ---
+
+// The synthesis model and whether joins are charged are template parameters
+// of the DP, chosen once per record: the price table is built with only the
+// arithmetic the model needs, and without joins the kernels drop the add.
+// Each model evaluates exactly like CostModel::synth.
+struct LinearSynth {
+    double rate;
+    double operator()(int w) const { return rate * static_cast<double>(w); }
+};
+
+struct QuadraticSynth {
+    double rate;
+    double quad;
+    double operator()(int w) const {
+        const double x = static_cast<double>(w);
+        return rate * x + quad * x * x;
+    }
+};
+
+struct TabulatedSynth {
+    const double* by_length;
+    double operator()(int w) const { return by_length[w]; }
+};
+
+// Sequence-dependent costs of one record.
+struct RecordTerms {
+    PrimerPenalties primers;                       // reused blocks (empty when off)
+    const SynthComplexity* complexity = nullptr;   // synthesised blocks (null when off)
+    BoundaryMask boundaries;                       // forbidden junctions (empty when off)
+    // Circular records: the circle's length and its origin in the extension
+    // the terms and the profile are over (0, 0 for a linear record).
+    long long circle = 0;
+    long long origin = 0;
+};
+
+// DP costs in one numeric type: double, or whole units of 1 / costs.scale.
+template <typename Cost>
+struct DpCosts {
+    Cost join = 0;
+    std::vector<Cost> synth_rev;   // synth_rev[t] = cost of synthesising W - t bases
+    std::vector<Cost> pcr_rev;     // pcr_rev[t] = cost of reusing W - t bases
+    bool flat_pcr = true;          // every length has the same PCR cost
+    int reuse_min = 1;             // reusable block lengths, reuse_max <= W
+    int reuse_max = 0;
+    Cost multi_penalty = 0;        // added to repeated reusable blocks
+    bool unique_only = false;      // repeated blocks are synthesised instead
+    bool synth_reusable = false;   // reusable lengths are also offered as synthesis
+    int overlap = 0;               // bases each joined block shares with its predecessor
+    int max_mismatches = 0;        // mutagenic PCR of near-copies (CostModel::max_mismatches)
+    Cost mismatch_cost = 0;
+    std::vector<Cost> tier_extra;  // source price - pcr per ReuseProfile::tier_pcr (empty when off)
+    std::vector<Cost> primer_start;   // primer-site penalties by position (empty when off)
+    std::vector<Cost> primer_end;
+    const SynthComplexity* complexity = nullptr;
+    const BoundaryMask* boundaries = nullptr;   // forbidden junctions (null when off)
+    double scale = 0.0;            // units per cost for integer Cost
+
+    // DP value of a forbidden boundary: above every real plan, and still
+    // finite in integer units once a block and a join are added to it
+    // (solve_dp_model leaves the headroom).
+    static constexpr Cost unreachable() {
+        if constexpr (std::is_floating_point<Cost>::value) {
+            return std::numeric_limits<Cost>::infinity();
+        } else {
+            return std::numeric_limits<Cost>::max() / 2;
+        }
+    }
+    // Whether a DP value is a cost rather than unreachable() plus the blocks
+    // built on it: with forbidden boundaries real values stay below a
+    // quarter of the range (dp_integer_bits).
+    static bool reachable(Cost v) { return v < unreachable() / 2; }
+
+    // First base of the fragment of a block starting at j (j < overlap only
+    // for j = 0, whose block has no predecessor).
+    size_t fragment_start(long long j) const { return static_cast<size_t>(j >= overlap ? j - overlap : 0); }
+
+    Cost units(double x) const {
+        if constexpr (std::is_floating_point<Cost>::value) {
+            return x;
+        } else {
+            return static_cast<Cost>(std::llround(x * scale));
+        }
+    }
+};
+
+template <typename Cost, typename Synth>
+DpCosts<Cost> make_dp_costs(const CostModel& costs, const Synth& synth, const ReuseProfile& reuse, const RecordTerms& terms) {
+    const int W = reuse.W;
+    DpCosts<Cost> c;
+    c.scale = costs.scale;
+    auto convert = [&c](double x) { return c.units(x); };
+    c.join = convert(costs.join);
+    c.synth_rev.resize(static_cast<size_t>(W));
+    c.pcr_rev.resize(static_cast<size_t>(W));
+    for (int t = 0; t < W; ++t) {
+        c.synth_rev[static_cast<size_t>(t)] = convert(synth(W - t));
+        c.pcr_rev[static_cast<size_t>(t)] = convert(costs.pcr_cost(W - t));
+    }
+    c.flat_pcr = (costs.pcr_per_base == 0.0);
+    c.reuse_min = std::max(1, costs.reuse_min);
+    c.reuse_max = (costs.reuse_max > 0) ? std::min(W, costs.reuse_max) : W;
+    c.multi_penalty = convert(costs.multi_penalty);
+    c.unique_only = costs.unique_only;
+    c.synth_reusable = costs.synth_reusable;
+    c.overlap = costs.overlap;
+    c.max_mismatches = costs.max_mismatches;
+    c.mismatch_cost = convert(costs.mismatch_cost);
+    for (const double p : reuse.tier_pcr) c.tier_extra.push_back(convert(p - costs.pcr));
+    for (const double p : terms.primers.start) c.primer_start.push_back(convert(p));
+    for (const double p : terms.primers.end) c.primer_end.push_back(convert(p));
+    c.complexity = terms.complexity;
+    if (!terms.boundaries.empty()) c.boundaries = &terms.boundaries;
+    return c;
+}
+
+// Walks chosen_len / chosen_is_reuse back from last to the cut at first; the
+// block ending at i starts at i - chosen_len[i] and costs DP[i] - DP[i -
+// chosen_len[i]].  chosen_is_reuse is 0 for synthesis, else 1 plus the
+// block's mismatches.  Block starts are relative to first.
+template <typename Cost>
+PlannerStats backtrack_dp(long long first, long long last, const std::vector<Cost>& DP, double unit,
+                          const std::vector<uint16_t>& chosen_len, const std::vector<uint8_t>& chosen_is_reuse,
+                          std::vector<PlanBlock>* blocks) {
+    PlannerStats stats;
+    stats.length = static_cast<std::uint64_t>(last - first);
+    stats.cost = (last > first) ? static_cast<double>(DP[static_cast<size_t>(last)] - DP[static_cast<size_t>(first)]) / unit : 0.0;
+
+    // Backtrack to count moves.
+    if (blocks) blocks->clear();
+    long long cur = last;
+    while (cur > first) {
+        const uint16_t len = chosen_len[static_cast<size_t>(cur)];
+        const uint8_t is_reuse = chosen_is_reuse[static_cast<size_t>(cur)];
+
+        if (len == 0 || len > cur - first) {
+            // Should not happen, but avoid infinite loops.
+            break;
+        }
+        const long long p = cur - len;
+
+        stats.segments++;
+        if (is_reuse) {
+            stats.reuse_moves++;
+            stats.reuse_bases += len;
+            stats.mismatches += is_reuse - 1u;
+        } else {
+            stats.synth_moves++;
+            stats.synth_bases += len;
+        }
+        if (blocks) {
+            const double cost = static_cast<double>(DP[static_cast<size_t>(cur)] - DP[static_cast<size_t>(p)]) / unit;
+            PlanBlock block{static_cast<std::uint64_t>(p - first), len, is_reuse != 0, cost};
+            block.mismatches = static_cast<std::uint8_t>(is_reuse > 0 ? is_reuse - 1 : 0);
+            blocks->push_back(block);
+        }
+        cur = p;
+    }
+    if (blocks) std::reverse(blocks->begin(), blocks->end());
+    stats.joins = (stats.segments > 0) ? (stats.segments - 1) : 0;
+    return stats;
+}
+
+// DP state over the positions of a record (or of its circular extension),
+// or over a window of them starting at position base.
+template <typename Cost>
+struct DpTables {
+    std::vector<Cost> DP;
+    std::vector<Cost> DPr;                  // DP + primer_start (empty when off)
+    std::vector<uint16_t> chosen_len;       // the block ending at i starts at i - chosen_len[i]
+    std::vector<uint8_t> chosen_is_reuse;   // 0 synthesised, 1 + mismatches reused
+    long long base = 0;                     // position of entry 0
+
+    DpTables(size_t n, bool primed) : DP(n, 0), DPr(primed ? n : 0, 0), chosen_len(n, 0), chosen_is_reuse(n, 0) {}
+};
+
+// Optimal DP over block boundaries.  DP[i] is the cheapest plan for seq[0, i);
+// blocks of length w <= end_len[i] within [reuse_min, reuse_max] are
+// reusable, all others are synthesised.  Repeated blocks (w <= multi_len[i])
+// pay multi_penalty, or are synthesised with unique_only.  A reused block
+// [j, i) also pays primer_start[j] + primer_end[i]: the first term is folded
+// into DPr[j] = DP[j] + primer_start[j] once DP[j] is known, the second is
+// constant per i, so primer scoring keeps one kernel run per candidate run.
+// Synthesised blocks may add a complexity penalty (GC, homopolymers, repeats).
+// A forbidden boundary j < N gets DP[j] = unreachable, so no block ends or
+// starts there and the kernels still scan contiguous runs.
+// With an overlap o, a block [j, i) with j > 0 is acquired as the fragment
+// [j - o, i): lengths, prices, reuse limits and primer sites all refer to the
+// fragment, which is reusable iff w + o <= end_len[i], so the profile is
+// unchanged and the price tables are read o entries further left.
+// Ties go to the shortest block, reuse before synthesis.
+//
+// run_dp solves positions (first, last] from a cut at first (DP[first] = 0)
+// whose block is acquired with `lead` bases before it: 0 for a record start,
+// o on a circle, where the first block has a predecessor too (its join is
+// charged by the caller).  With a reference run from an earlier cut it stops
+// once DP has stayed parallel to it (a constant difference, *shift) over W
+// positions: from there on both draw on the same W predecessors, none of
+// them a first cut, so every later DP[i] is reference[i] + *shift.  Returns
+// the position it stopped at.  With from > first + 1 it resumes there: DP
+// (and DPr) before from already hold this run's values.  t may be a window
+// of the positions (t.base > 0, or fewer entries than last + 1); it must
+// hold the W positions before from (and first while from <= first + W),
+// and the run stops at its last entry.
+template <typename Cost, bool Joins>
+long long run_dp(const ReuseProfile& reuse, const DpCosts<Cost>& c, long long first, long long last, int lead,
+                 DpTables<Cost>& t, const DpTables<Cost>* reference = nullptr, Cost* shift = nullptr,
+                 long long from = 0) {
+    const int W = reuse.W;
+    std::vector<Cost>& DP = t.DP;
+    std::vector<Cost>& DPr = t.DPr;
+    const bool primed = !c.primer_start.empty();
+    // Entry of position x in the tables.
+    auto at = [&t](long long x) { return static_cast<size_t>(x - t.base); };
+    const long long end = std::min(last, t.base + static_cast<long long>(DP.size()) - 1);
+    if (from <= first + 1) {
+        DP[at(first)] = 0;
+        if (primed) DPr[at(first)] = c.primer_start[static_cast<size_t>(first - lead)];
+    }
+    const std::vector<Cost>& reuse_base = primed ? DPr : DP;
+    // With complexity rules the synthesis price depends on the block, so the
+    // table is rebuilt for every i (O(1) per length, see SynthComplexity).
+    std::vector<double> complexity;
+    std::vector<Cost> synth_acq;
+    if (c.complexity) {
+        complexity.resize(static_cast<size_t>(W) + 1);
+        synth_acq = c.synth_rev;
+    }
+    const std::vector<Cost>& synth_table = c.complexity ? synth_acq : c.synth_rev;
+    // Parallel run against the reference, see above.
+    int parallel = 0;
+    Cost delta = 0;
+    auto same = [](Cost a, Cost b, Cost scale) {
+        if constexpr (std::is_floating_point<Cost>::value) {
+            return std::fabs(a - b) <= 1e-9 * std::max<Cost>(1, std::fabs(scale));
+        } else {
+            return a == b;
+        }
+    };
+
+    // Candidate costs are DP[j] + table[j - i + W] (+ join + extra), with both
+    // arrays ascending in j, so each run of candidates is one min_plus_argmin call.
+    auto run_min = [&c](const Cost* dp, const Cost* table, Cost extra, size_t n) {
+        if constexpr (Joins) {
+            return min_plus_argmin(dp, table, static_cast<Cost>(c.join + extra), n);
+        } else {
+            return extra != 0 ? min_plus_argmin(dp, table, extra, n) : min_plus_argmin(dp, table, n);
+        }
+    };
+    for (long long i = std::max(first + 1, from); i <= end; ++i) {
+        if (c.boundaries && i < last && c.boundaries->blocked(static_cast<size_t>(i))) {
+            DP[at(i)] = DpCosts<Cost>::unreachable();
+            if (primed) DPr[at(i)] = DpCosts<Cost>::unreachable();
+            // Unreachable in both runs alike.
+            if (reference && parallel > 0 && ++parallel >= W) {
+                *shift = delta;
+                return i;
+            }
+            continue;
+        }
+        Cost min_cost_for_i = 0;
+        bool found = false;
+        // Longest fragment ending at i.
+        const int max_w = static_cast<int>(std::min<long long>(W, i - first + lead));
+        // Reusable and repeated fragment lengths.
+        const int reuse_f = std::min<int>({reuse.end_len[static_cast<size_t>(i)], max_w, c.reuse_max});
+        const int multi_f = reuse.multi_len.empty() ? 0 : std::min<int>(reuse.multi_len[static_cast<size_t>(i)], reuse_f);
+        // The block from the first cut pays no join and is handled last.
+        // Joined blocks start at j > first with their fragment from
+        // j - o >= first - lead.
+        const int o = c.overlap;
+        const int joined_w = static_cast<int>(std::min<long long>(W - o, i - first - std::max(1, o - lead)));
+        // acquired: 0 synthesis, 1 + mismatches reuse (chosen_is_reuse).
+        auto take = [&](long long j, int acquired, Cost path_cost) {
+            if (found && !(path_cost < min_cost_for_i)) return;
+            found = true;
+            min_cost_for_i = path_cost;
+            t.chosen_len[at(i)] = static_cast<uint16_t>(i - j);
+            t.chosen_is_reuse[at(i)] = static_cast<uint8_t>(acquired);
+        };
+        // Joined lengths w in [w_from, w_to] over base (DP or DPr), priced by
+        // table (indexed like synth_rev) at the fragment length w + o.
+        auto scan = [&](int w_from, int w_to, const std::vector<Cost>& base, const std::vector<Cost>& table, int acquired,
+                        Cost extra) {
+            if (w_from > w_to) return;
+            const long long j0 = i - w_to;
+            const auto m = run_min(&base[at(j0)], &table[static_cast<size_t>(W - o - w_to)], extra,
+                                   static_cast<size_t>(w_to - w_from + 1));
+            // No index when every candidate is unreachable (infinite with
+            // double costs): keep the best so far.
+            if (m.index >= 0) take(j0 + m.index, acquired, m.value);
+        };
+        const Cost primer = primed ? c.primer_end[static_cast<size_t>(i)] : 0;
+        if (c.complexity) {
+            c.complexity->penalties_ending_at(static_cast<size_t>(i), max_w, complexity.data());
+            for (int w = 1; w <= max_w; ++w) {
+                const size_t r = static_cast<size_t>(W - w);
+                synth_acq[r] = static_cast<Cost>(c.synth_rev[r] + c.units(complexity[static_cast<size_t>(w)]));
+            }
+        }
+
+        // In w order: synthesis below reuse_min (or of repeated blocks with
+        // unique_only), the repeated then the unique reusable run, then
+        // synthesis of everything longer, so ties keep the shortest block.
+        // The reusable run is cut where the cheapest source holding the block
+        // changes.  With mismatches the lengths past it are also offered as
+        // mutagenic PCR, one run per mismatch count, before synthesis.
+        const int reuse_w = reuse_f - o;
+        const int multi_w = multi_f - o;
+        int below = std::max(0, std::min(c.reuse_min - 1 - o, joined_w));
+        if (c.unique_only) below = std::max(below, std::min(multi_w, joined_w));
+        const int reuse_to = std::max(below, std::min(reuse_w, joined_w));
+        const int repeated_to = std::max(below, std::min(multi_w, reuse_to));
+        scan(1, below, DP, synth_table, 0, 0);
+        if (c.tier_extra.empty()) {
+            scan(below + 1, repeated_to, reuse_base, c.pcr_rev, 1, static_cast<Cost>(c.multi_penalty + primer));
+            scan(repeated_to + 1, reuse_to, reuse_base, c.pcr_rev, 1, primer);
+        } else {
+            size_t tier = 0;
+            for (int w = below; w < reuse_to;) {
+                int to = reuse_to;
+                Cost extra = primer;
+                if (w < repeated_to) {
+                    to = repeated_to;
+                    extra = static_cast<Cost>(extra + c.multi_penalty);
+                }
+                while (tier < c.tier_extra.size() && reuse.tier_len[tier][static_cast<size_t>(i)] - o <= w) ++tier;
+                if (tier < c.tier_extra.size()) {
+                    to = std::min(to, reuse.tier_len[tier][static_cast<size_t>(i)] - o);
+                    extra = static_cast<Cost>(extra + c.tier_extra[tier]);
+                }
+                scan(w + 1, to, reuse_base, c.pcr_rev, 1, extra);
+                w = to;
+            }
+        }
+        int approx_to = reuse_to;
+        for (int d = 1; d <= c.max_mismatches; ++d) {
+            const int approx_f = std::min<int>({reuse.approx_len[static_cast<size_t>(d - 1)][static_cast<size_t>(i)], max_w, c.reuse_max});
+            const int to = std::max(approx_to, std::min(approx_f - o, joined_w));
+            scan(approx_to + 1, to, reuse_base, c.pcr_rev, 1 + d, static_cast<Cost>(primer + d * c.mismatch_cost));
+            approx_to = to;
+        }
+        if (c.synth_reusable) scan(below + 1, reuse_to, DP, synth_table, 0, 0);
+        scan(reuse_to + 1, joined_w, DP, synth_table, 0, 0);
+        if (i - first + lead <= W) {
+            const bool repeated = max_w <= multi_f;
+            const bool is_reuse = (max_w >= c.reuse_min && max_w <= reuse_f && !(repeated && c.unique_only));
+            const std::vector<Cost>& table = is_reuse ? c.pcr_rev : synth_table;
+            Cost extra = is_reuse ? static_cast<Cost>((repeated ? c.multi_penalty : 0) + primer) : 0;
+            const int tier = is_reuse ? reuse.tier(static_cast<size_t>(i), max_w) : -1;
+            if (tier >= 0) extra = static_cast<Cost>(extra + c.tier_extra[static_cast<size_t>(tier)]);
+            if (!is_reuse && max_w >= c.reuse_min && max_w <= c.reuse_max) {
+                const int d = reuse.mismatches(static_cast<size_t>(i), max_w);
+                if (d > 0 && d <= c.max_mismatches) {
+                    take(first, 1 + d, static_cast<Cost>(reuse_base[at(first)] + c.pcr_rev[static_cast<size_t>(W - max_w)] +
+                                                         primer + d * c.mismatch_cost));
+                }
+            }
+            take(first, is_reuse ? 1 : 0, static_cast<Cost>((is_reuse ? reuse_base : DP)[at(first)] +
+                                                            table[static_cast<size_t>(W - max_w)] + extra));
+            if (is_reuse && c.synth_reusable) {
+                take(first, 0, static_cast<Cost>(DP[at(first)] + synth_table[static_cast<size_t>(W - max_w)]));
+            }
+        }
+
+        // Every candidate unreachable: so is i.
+        if (!found) min_cost_for_i = DpCosts<Cost>::unreachable();
+        DP[at(i)] = min_cost_for_i;
+        if (primed) {
+            DPr[at(i)] = found ? static_cast<Cost>(min_cost_for_i + c.primer_start[c.fragment_start(i)]) : DpCosts<Cost>::unreachable();
+        }
+        if (reference) {
+            const Cost d = static_cast<Cost>(min_cost_for_i - reference->DP[static_cast<size_t>(i)]);
+            if (parallel > 0 && same(d, delta, min_cost_for_i)) {
+                ++parallel;
+            } else {
+                delta = d;
+                parallel = 1;
+            }
+            if (parallel >= W) {
+                *shift = delta;
+                return i;
+            }
+        }
+    }
+    return end;
+}
+
+template <typename Cost, bool Joins>
+PlannerStats solve_dp(long long N, const ReuseProfile& reuse, const DpCosts<Cost>& c, std::vector<PlanBlock>* blocks,
+                      double unit) {
+    DpTables<Cost> t(static_cast<size_t>(N) + 1, !c.primer_start.empty());
+    run_dp<Cost, Joins>(reuse, c, 0, N, 0, t);
+    return backtrack_dp(0, N, t.DP, unit, t.chosen_len, t.chosen_is_reuse, blocks);
+}
+
+// Blocks of a cycle with starts taken mod N, rotated to ascending starts so
+// that only the last one can wrap.
+void order_circular_blocks(std::vector<PlanBlock>& blocks, long long N) {
+    for (PlanBlock& block : blocks) block.start %= static_cast<std::uint64_t>(N);
+    const auto lowest = std::min_element(blocks.begin(), blocks.end(),
+                                         [](const PlanBlock& a, const PlanBlock& b) { return a.start < b.start; });
+    std::rotate(blocks.begin(), lowest, blocks.end());
+}
+
+// Circular records, over the extension starting `origin` bases before the
+// circle.  A cut falls in every W boundaries, so the best cycle has a first
+// cut k in [0, min(W, N)) and is a plan of [origin + k, origin + k + N)
+// whose first block is joined to the last, plus the closing join.  The DP
+// from k = 0 runs over the whole extension; from k > 0 it runs only until
+// it is parallel to that one (run_dp), after which its remaining values are
+// known but for the last (close_cycle).  That one also bounds every cycle: its plan to the cut at k
+// followed by the cycle from k is a plan to k + N, so the cycle costs at
+// least DP_0[k + N] - DP_0[k], and starts that cannot win are skipped.  This
+// is exact (to rounding with double costs) and costs a few blocks per start
+// where reused blocks pull the plans onto the same cuts; long stretches
+// without reuse keep them apart, up to a full pass per start, so the starts
+// are run in parallel (OpenMP).
+template <typename Cost, bool Joins>
+PlannerStats solve_dp_circular(long long N, long long origin, const ReuseProfile& reuse, const DpCosts<Cost>& c,
+                               std::vector<PlanBlock>* blocks, double unit) {
+    const long long cuts = std::min<long long>(reuse.W, N);
+    const bool primed = !c.primer_start.empty();
+    DpTables<Cost> ref(reuse.end_len.size(), primed);
+    run_dp<Cost, Joins>(reuse, c, origin, origin + cuts - 1 + N, c.overlap, ref);
+    auto open = [&](long long k) { return !c.boundaries || !c.boundaries->blocked(static_cast<size_t>(origin + k)); };
+    auto at = [&](long long x) { return ref.DP[static_cast<size_t>(x)]; };
+    // Position last of the cycle from first, whose DP is t's up to stop and
+    // ref + shift after it.  The reference runs on past last, so it may have
+    // last blocked (boundaries reopened inside forbidden runs recur every W,
+    // not every N): last is solved again over the W positions before it.
+    auto close_cycle = [&](long long first, const DpTables<Cost>& t, long long stop, Cost shift) {
+        const long long last = first + N;
+        DpTables<Cost> w(static_cast<size_t>(N < reuse.W ? N + 1 : reuse.W + 1), primed);
+        w.base = last - static_cast<long long>(w.DP.size()) + 1;
+        for (long long x = w.base; x < last; ++x) {
+            const DpTables<Cost>& from = x <= stop ? t : ref;
+            const Cost add = x <= stop ? 0 : shift;
+            const size_t u = static_cast<size_t>(x), v = static_cast<size_t>(x - w.base);
+            w.DP[v] = DpCosts<Cost>::reachable(from.DP[u]) ? static_cast<Cost>(from.DP[u] + add) : from.DP[u];
+            if (primed) w.DPr[v] = DpCosts<Cost>::reachable(from.DPr[u]) ? static_cast<Cost>(from.DPr[u] + add) : from.DPr[u];
+        }
+        run_dp<Cost, Joins>(reuse, c, first, last, c.overlap, w, nullptr, nullptr, last);
+        return w;
+    };
+    // a < b beyond the rounding of a difference of DP values.
+    auto below = [](Cost a, Cost b) {
+        if constexpr (std::is_floating_point<Cost>::value) {
+            return a < b - 1e-9 * std::max<Cost>(1, std::fabs(b));
+        } else {
+            return a < b;
+        }
+    };
+
+    // Cycle costs without the closing join; a start is skipped once its bound
+    // exceeds a cycle already found, or reaches that of k = 0, so ties still
+    // go to the lowest start.
+    std::vector<Cost> cycle(static_cast<size_t>(cuts), 0);
+    std::vector<char> solved(static_cast<size_t>(cuts), 0);
+    bool found = open(0);
+    Cost best = found ? close_cycle(origin, ref, origin + N, 0).DP.back() : 0;
+    if (found) {
+        cycle[0] = best;
+        solved[0] = 1;
+    }
+    #pragma omp parallel
+    {
+        DpTables<Cost> run(reuse.end_len.size(), primed);
+        #pragma omp for schedule(dynamic, 1)
+        for (long long k = 1; k < cuts; ++k) {
+            if (!open(k)) continue;
+            const long long first = origin + k;
+            const long long last = first + N;
+            // No bound where the reference cannot reach first or last.
+            if (DpCosts<Cost>::reachable(at(first)) && DpCosts<Cost>::reachable(at(last))) {
+                const Cost bound = static_cast<Cost>(at(last) - at(first) - c.join);
+                bool skip = solved[0] && !below(bound, cycle[0]);   // ties go to k = 0
+                #pragma omp critical(circular_best)
+                skip = skip || (found && below(best, bound));
+                if (skip) continue;
+            }
+            Cost shift = 0;
+            const long long stop = run_dp<Cost, Joins>(reuse, c, first, last, c.overlap, run, &ref, &shift);
+            const Cost cost = (stop == last) ? run.DP[static_cast<size_t>(last)] : close_cycle(first, run, stop, shift).DP.back();
+            #pragma omp critical(circular_best)
+            {
+                cycle[static_cast<size_t>(k)] = cost;
+                solved[static_cast<size_t>(k)] = 1;
+                if (!found || cost < best) best = cost;
+                found = true;
+            }
+        }
+    }
+    long long best_k = 0;
+    for (long long k = 0; k < cuts; ++k) {
+        if (solved[static_cast<size_t>(k)] && (!solved[static_cast<size_t>(best_k)] || cycle[static_cast<size_t>(k)] < cycle[static_cast<size_t>(best_k)])) {
+            best_k = k;
+        }
+    }
+    // A cut falls in every W boundaries of the extension (forbidden_boundaries),
+    // but a circle shorter than W may have none: then there is no plan.
+    if (!solved[static_cast<size_t>(best_k)] || !DpCosts<Cost>::reachable(cycle[static_cast<size_t>(best_k)])) {
+        PlannerStats stats;
+        stats.planned = false;
+        return stats;
+    }
+
+    const long long first = origin + best_k;
+    const long long last = first + N;
+    DpTables<Cost> run(best_k > 0 ? reuse.end_len.size() : 0, primed);
+    DpTables<Cost>* path = &ref;
+    long long stop = last;
+    Cost shift = 0;
+    if (best_k > 0) {
+        stop = run_dp<Cost, Joins>(reuse, c, first, last, c.overlap, run, &ref, &shift);
+        for (long long x = stop + 1; x < last; ++x) {
+            const size_t u = static_cast<size_t>(x);
+            run.DP[u] = static_cast<Cost>(ref.DP[u] + shift);
+            run.chosen_len[u] = ref.chosen_len[u];
+            run.chosen_is_reuse[u] = ref.chosen_is_reuse[u];
+        }
+        path = &run;
+    }
+    if (stop < last || best_k == 0) {
+        const DpTables<Cost> closed = close_cycle(first, *path, stop, shift);
+        const size_t u = static_cast<size_t>(last);
+        path->DP[u] = closed.DP.back();
+        path->chosen_len[u] = closed.chosen_len.back();
+        path->chosen_is_reuse[u] = closed.chosen_is_reuse.back();
+    }
+    PlannerStats stats = backtrack_dp(first, last, path->DP, unit, path->chosen_len, path->chosen_is_reuse, blocks);
+    const double join = static_cast<double>(c.join) / unit;
+    stats.cost += join;
+    stats.joins = stats.segments;
+    if (blocks && !blocks->empty()) {
+        for (PlanBlock& block : *blocks) block.start += static_cast<std::uint64_t>(best_k);
+        blocks->front().cost += join;
+        order_circular_blocks(*blocks, N);
+    }
+    return stats;
+}
+
+// Minimum of DP[j] over a window [lo, hi] whose ends only move right, as a
+// monotone queue of positions (values increasing front to back).  Equal
+// values keep the largest j, i.e. the shortest block.  Returns -1 for an
+// empty window.
+template <typename Cost>
+class WindowMin {
+public:
+    explicit WindowMin(int W) {
+        size_t cap = 1;
+        while (cap < static_cast<size_t>(W) + 2) cap <<= 1;
+        ring_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    long long query(const std::vector<Cost>& DP, long long lo, long long hi) {
+        if (hi < next_ - 1) {
+            // The right end moved left (only when reuse_min hides the
+            // shorter matches before a reusable run); answer it directly.
+            long long best = -1;
+            for (long long j = lo; j <= hi; ++j) {
+                if (best < 0 || !(DP[static_cast<size_t>(best)] < DP[static_cast<size_t>(j)])) best = j;
+            }
+            return best;
+        }
+        while (head_ != tail_ && ring_[head_ & mask_] < lo) ++head_;
+        for (next_ = std::max(next_, lo); next_ <= hi; ++next_) {
+            while (tail_ != head_ && !(DP[static_cast<size_t>(ring_[(tail_ - 1) & mask_])] < DP[static_cast<size_t>(next_)])) --tail_;
+            ring_[tail_++ & mask_] = next_;
+        }
+        return head_ == tail_ ? -1 : ring_[head_ & mask_];
+    }
+
+private:
+    std::vector<long long> ring_;
+    size_t mask_ = 0;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    long long next_ = 1;   // first position not yet pushed; j = 0 is handled apart
+};
+
+// A run of block lengths [lo_w, hi_w] with one synthesis price.
+template <typename Cost>
+struct PriceTier {
+    int lo_w;
+    int hi_w;
+    Cost price;
+};
+
+template <typename Cost>
+std::vector<PriceTier<Cost>> price_tiers(const DpCosts<Cost>& c, int W) {
+    std::vector<PriceTier<Cost>> tiers;
+    for (int w = 1; w <= W; ++w) {
+        const Cost price = c.synth_rev[static_cast<size_t>(W - w)];
+        if (!tiers.empty() && tiers.back().price == price) {
+            tiers.back().hi_w = w;
+        } else {
+            tiers.push_back({w, w, price});
+        }
+    }
+    return tiers;
+}
+
+// The same DP for step-function prices.  Every candidate run has a constant
+// acquisition cost, so its best predecessor is a sliding-window minimum of
+// DP: one window for the reusable run and two per price tier (lengths below
+// reuse_min, and above the reusable run), each moving right as i grows
+// (i - end_len[i] never decreases).  O(N * #tiers) instead of O(N * W).
+// Needs a length-independent PCR cost, no occurrence rule, no mismatches and
+// no synthesis complexity rules.  Tiers are fragment lengths, shifted by the overlap
+// like the scan's tables.  Costs match the scan exactly; with
+// double costs two plans whose totals round to the same value may be
+// tie-broken differently.
+template <typename Cost, bool Joins>
+PlannerStats solve_dp_tiered(long long N, const ReuseProfile& reuse, const DpCosts<Cost>& c,
+                             const std::vector<PriceTier<Cost>>& tiers, std::vector<PlanBlock>* blocks, double unit) {
+    const int W = reuse.W;
+    if (N == 0) return backtrack_dp<Cost>(0, 0, {}, unit, {}, {}, blocks);
+    std::vector<Cost> DP(static_cast<size_t>(N) + 1, 0);
+    std::vector<uint16_t> chosen_len(static_cast<size_t>(N) + 1, 0);
+    std::vector<uint8_t> chosen_is_reuse(static_cast<size_t>(N) + 1, 0);
+    WindowMin<Cost> reuse_window(W);
+    std::vector<WindowMin<Cost>> short_windows(tiers.size(), WindowMin<Cost>(W));
+    std::vector<WindowMin<Cost>> long_windows(tiers.size(), WindowMin<Cost>(W));
+    const Cost pcr = c.pcr_rev[0];
+    // Reused blocks run over DPr = DP + primer_start, as in solve_dp.
+    const bool primed = !c.primer_start.empty();
+    std::vector<Cost> DPr;
+    if (primed) {
+        DPr.assign(static_cast<size_t>(N) + 1, 0);
+        DPr[0] = c.primer_start[0];
+    }
+    const std::vector<Cost>& reuse_base = primed ? DPr : DP;
+
+    auto path_cost = [&](const std::vector<Cost>& base, long long j, Cost acquisition) -> Cost {
+        if constexpr (Joins) {
+            return base[static_cast<size_t>(j)] + acquisition + c.join;
+        } else {
+            return base[static_cast<size_t>(j)] + acquisition;
+        }
+    };
+    for (long long i = 1; i <= N; ++i) {
+        if (c.boundaries && i < N && c.boundaries->blocked(static_cast<size_t>(i))) {
+            DP[static_cast<size_t>(i)] = DpCosts<Cost>::unreachable();
+            if (primed) DPr[static_cast<size_t>(i)] = DpCosts<Cost>::unreachable();
+            continue;
+        }
+        Cost min_cost_for_i = 0;
+        bool found = false;
+        const int max_w = static_cast<int>(std::min<long long>(W, i));
+        const int reuse_f = std::min<int>({reuse.end_len[static_cast<size_t>(i)], max_w, c.reuse_max});
+        const int o = c.overlap;
+        const int joined_w = static_cast<int>(std::min<long long>(W - o, i - std::max(1, o)));
+        auto take = [&](long long j, bool is_reuse, Cost cost) {
+            if (found && !(cost < min_cost_for_i)) return;
+            found = true;
+            min_cost_for_i = cost;
+            chosen_len[static_cast<size_t>(i)] = static_cast<uint16_t>(i - j);
+            chosen_is_reuse[static_cast<size_t>(i)] = static_cast<uint8_t>(is_reuse ? 1 : 0);
+        };
+
+        // Synthesised lengths in [w_lo, w_hi], one window per tier.
+        auto tier_runs = [&](std::vector<WindowMin<Cost>>& windows, int w_lo, int w_hi) {
+            for (size_t t = 0; t < tiers.size(); ++t) {
+                const int w_from = std::max(tiers[t].lo_w - o, w_lo);
+                const int w_to = std::min(tiers[t].hi_w - o, w_hi);
+                if (w_from > w_to) continue;
+                const long long j = windows[t].query(DP, i - w_to, i - w_from);
+                if (j >= 0) take(j, false, path_cost(DP, j, tiers[t].price));
+            }
+        };
+
+        const Cost reuse_cost = primed ? static_cast<Cost>(pcr + c.primer_end[static_cast<size_t>(i)]) : pcr;
+        const int below = std::max(0, std::min(c.reuse_min - 1 - o, joined_w));
+        const int reuse_to = std::max(below, std::min(reuse_f - o, joined_w));
+        tier_runs(short_windows, 1, below);
+        if (reuse_to > below) {
+            const long long j = reuse_window.query(reuse_base, i - reuse_to, i - below - 1);
+            take(j, true, path_cost(reuse_base, j, reuse_cost));
+        }
+        tier_runs(long_windows, reuse_to + 1, joined_w);
+        if (i <= W) {
+            const bool is_reuse = (max_w >= c.reuse_min && max_w <= reuse_f);
+            take(0, is_reuse, static_cast<Cost>(is_reuse ? reuse_base[0] + reuse_cost
+                                                         : DP[0] + c.synth_rev[static_cast<size_t>(W - max_w)]));
+        }
+
+        DP[static_cast<size_t>(i)] = min_cost_for_i;
+        if (primed) DPr[static_cast<size_t>(i)] = static_cast<Cost>(min_cost_for_i + c.primer_start[c.fragment_start(i)]);
+    }
+    return backtrack_dp(0, N, DP, unit, chosen_len, chosen_is_reuse, blocks);
+}
+
+// PLANNER_DP=scan keeps price brackets on the scan, to compare the two.
+// Read on every record so a test can switch it between calls.
+bool tiered_dp_disabled() {
+    const char* forced = std::getenv("PLANNER_DP");
+    return forced && std::string(forced) == "scan";
+}
+
+template <typename Cost, typename Synth>
+PlannerStats solve_dp_in(long long N, const ReuseProfile& reuse, const CostModel& costs, const Synth& synth,
+                         const RecordTerms& terms, std::vector<PlanBlock>* blocks, double unit) {
+    const DpCosts<Cost> c = make_dp_costs<Cost>(costs, synth, reuse, terms);
+    if (terms.circle > 0) {
+        if (c.join != 0) return solve_dp_circular<Cost, true>(terms.circle, terms.origin, reuse, c, blocks, unit);
+        return solve_dp_circular<Cost, false>(terms.circle, terms.origin, reuse, c, blocks, unit);
+    }
+    if constexpr (std::is_same<Synth, TabulatedSynth>::value) {
+        // Vendor price lists are a handful of brackets; once the windows are
+        // cheaper than a vector scan over W candidates, use them.
+        const std::vector<PriceTier<Cost>> tiers = price_tiers(c, reuse.W);
+        if (c.flat_pcr && !c.synth_reusable && reuse.multi_len.empty() && reuse.approx_len.empty() && reuse.tier_len.empty() && !c.complexity && tiers.size() * 16 <= static_cast<size_t>(reuse.W) && !tiered_dp_disabled()) {
+            if (c.join != 0) return solve_dp_tiered<Cost, true>(N, reuse, c, tiers, blocks, unit);
+            return solve_dp_tiered<Cost, false>(N, reuse, c, tiers, blocks, unit);
+        }
+    }
+    if (c.join != 0) return solve_dp<Cost, true>(N, reuse, c, blocks, unit);
+    return solve_dp<Cost, false>(N, reuse, c, blocks, unit);
+}
+
+// Integer width of the DP state in units of 1 / costs.scale: 32 or 64 bits,
+// or 0 for floating point (no scale, or a record that could overflow int64).
+template <typename Synth>
+int dp_integer_bits(long long N, int W, const CostModel& costs, const Synth& synth, const RecordTerms& terms) {
+    if (costs.scale > 0.0) {
+        // Bound every DP value and candidate.  With non-negative costs DP[j]
+        // is at most j single-base syntheses plus joins (each fragment 1 + o
+        // bases long with its worst complexity penalty), and a candidate adds
+        // one block and one join to it.  Otherwise each of up to N + 1 blocks
+        // is worth at most 2 * M units.  int32 halves DP memory and doubles
+        // the SIMD lanes, so it is used whenever the record fits.
+        const double units = costs.scale;
+        double M = std::fabs(costs.join);
+        double primer = 0.0;   // worst primer penalty of one block
+        bool blocks_non_negative = true;
+        if (!terms.primers.empty()) {
+            auto magnitude = [](const std::vector<double>& v) {
+                double m = 0.0;
+                for (const double p : v) m = std::max(m, std::fabs(p));
+                return m;
+            };
+            primer = magnitude(terms.primers.start) + magnitude(terms.primers.end);
+            blocks_non_negative = costs.primer.penalty >= 0.0;
+        }
+        // Worst synthesis complexity penalty: 100 GC points plus two runs of W.
+        const double complexity = terms.complexity ? costs.synth_rules.penalty * (100.0 + 2.0 * W) : 0.0;
+        // Reused blocks at the cheapest and the dearest source price.
+        double pcr_lo = costs.pcr, pcr_hi = costs.pcr;
+        for (const double p : costs.source_pcr) {
+            pcr_lo = std::min(pcr_lo, p);
+            pcr_hi = std::max(pcr_hi, p);
+        }
+        for (int w = 1; w <= W; ++w) {
+            const double reused = costs.pcr_cost(w);
+            const double cheapest = reused + (pcr_lo - costs.pcr);
+            const double dearest = reused + (pcr_hi - costs.pcr);
+            const double mutagenic = reused + costs.max_mismatches * costs.mismatch_cost;
+            M = std::max({M, std::fabs(synth(w)) + complexity, std::fabs(cheapest) + primer, std::fabs(dearest) + primer,
+                          std::fabs(cheapest + costs.multi_penalty) + primer, std::fabs(dearest + costs.multi_penalty) + primer,
+                          std::fabs(mutagenic) + primer});
+            blocks_non_negative = blocks_non_negative && synth(w) >= 0.0 && cheapest >= 0.0 &&
+                                  cheapest + costs.multi_penalty >= 0.0 && mutagenic >= 0.0;
+        }
+        const bool non_negative = costs.join >= 0.0 && blocks_non_negative;
+        const double per_base = synth(1 + costs.overlap) + complexity + costs.join;
+        // Forbidden boundaries hold half the range (DpCosts::unreachable);
+        // real values must stay below half of that, with candidates built on
+        // them below the other half.
+        const double headroom = terms.boundaries.empty() ? 1.0 : 0.25;
+        double bound = non_negative
+            ? static_cast<double>(N) * (per_base * units + 2.0) + 2.0 * (M * units + 1.0)
+            : (static_cast<double>(N) + 1.0) * 2.0 * (M * units + 1.0);
+        if (non_negative && !terms.boundaries.empty()) {
+            // Around forbidden runs blocks are up to W bases long.
+            bound = std::max(bound, static_cast<double>(N) * ((M + std::fabs(costs.join)) * units + 2.0) + 2.0 * (M * units + 1.0));
+        }
+        if (bound < 2147483647.0 * headroom) return 32;
+        if (bound < 4.0e18 * headroom) return 64;
+        static std::atomic<bool> warned(false);
+        if (!warned.exchange(true)) {
+            std::cerr << "WARNING: Costs scaled by " << costs.scale
+                      << " could overflow 64-bit integers; planning in floating point instead" << std::endl;
+        }
+    }
+    return 0;
+}
+
+template <typename Synth>
+PlannerStats solve_dp_model(long long N, const ReuseProfile& reuse, const CostModel& costs, const Synth& synth,
+                            const RecordTerms& terms, std::vector<PlanBlock>* blocks) {
+    switch (dp_integer_bits(N, reuse.W, costs, synth, terms)) {
+    case 32: return solve_dp_in<std::int32_t>(N, reuse, costs, synth, terms, blocks, costs.scale);
+    case 64: return solve_dp_in<std::int64_t>(N, reuse, costs, synth, terms, blocks, costs.scale);
+    default: return solve_dp_in<double>(N, reuse, costs, synth, terms, blocks, 1.0);
+    }
+}
+
+// Sequence-dependent terms of seq (a record or its circular extension); the
+// complexity tables, if enabled, are kept in `complexity`.
+RecordTerms record_terms(const std::string& seq, const CostModel& costs, int W, std::unique_ptr<SynthComplexity>& complexity) {
+    RecordTerms terms;
+    terms.primers = primer_penalties(seq, costs.primer);
+    if (costs.synth_rules.enabled()) {
+        complexity.reset(new SynthComplexity(seq, costs.synth_rules));
+        terms.complexity = complexity.get();
+    }
+    terms.boundaries = forbidden_boundaries(seq, costs.forbidden_motifs, W - costs.overlap);
+    return terms;
+}
+
+} // namespace
+
+PlannerStats solve_dp_for_chromosome(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                     std::vector<PlanBlock>* blocks) {
+    // A circular record is planned on its extension, see circular_margin.
+    const bool circular = costs.circular && !chrom_seq.empty();
+    const long long margin = circular ? circular_margin(costs, reuse.W) : 0;
+    const std::string text = circular ? circular_extension(chrom_seq, margin) : std::string();
+    const std::string& seq = circular ? text : chrom_seq;
+    const long long N = static_cast<long long>(seq.length());
+    std::unique_ptr<SynthComplexity> complexity;
+    RecordTerms terms = record_terms(seq, costs, reuse.W, complexity);
+    if (circular) {
+        terms.circle = static_cast<long long>(chrom_seq.length());
+        terms.origin = margin;
+    }
+    if (!costs.synth_table.empty()) {
+        return solve_dp_model(N, reuse, costs, TabulatedSynth{costs.synth_table.data()}, terms, blocks);
+    }
+    if (costs.synth_quad != 0.0) {
+        return solve_dp_model(N, reuse, costs, QuadraticSynth{costs.synth_linear, costs.synth_quad}, terms, blocks);
+    }
+    return solve_dp_model(N, reuse, costs, LinearSynth{costs.synth_linear}, terms, blocks);
+}
+
+// --- INCREMENTAL DP ---
+
+struct DpSession::Impl {
+    virtual ~Impl() = default;
+    virtual double cost() const = 0;
+    virtual double evaluate(const ReuseProfile& candidate, const std::vector<long long>& changed) const = 0;
+    virtual void adopt(const ReuseProfile& candidate) = 0;
+};
+
+namespace {
+
+template <typename Cost>
+class DpSessionOf : public DpSession::Impl {
+public:
+    template <typename Synth>
+    DpSessionOf(const ReuseProfile& reuse, const CostModel& costs, const Synth& synth, RecordTerms terms,
+                std::unique_ptr<SynthComplexity> complexity, double unit)
+        : complexity_(std::move(complexity)), terms_(std::move(terms)), W_(reuse.W), unit_(unit),
+          N_(static_cast<long long>(reuse.end_len.size()) - 1), c_(make_dp_costs<Cost>(costs, synth, reuse, terms_)),
+          tables_(reuse.end_len.size(), !c_.primer_start.empty()) {
+        run(reuse, tables_, 0, nullptr, nullptr);
+    }
+
+    double cost() const override { return static_cast<double>(tables_.DP[static_cast<size_t>(N_)]) / unit_; }
+
+    // The candidate's DP lives in a window of a few W positions, slid along
+    // while it runs and reloaded from the reference (plus the shift) at each
+    // difference after a parallel stretch, so nothing is copied per call.
+    double evaluate(const ReuseProfile& candidate, const std::vector<long long>& changed) const override {
+        if (changed.empty()) return cost();
+        const bool primed = !c_.primer_start.empty();
+        DpTables<Cost> t(static_cast<size_t>(std::min<long long>(4LL * (W_ + 1), N_ + 1)), primed);
+        const long long window = static_cast<long long>(t.DP.size());
+        // Fills the W positions before i with the reference plus shift (0
+        // before the first difference; after a parallel stop i > W, so the
+        // cut at 0 is never shifted).
+        auto load = [&](long long i, Cost shift) {
+            t.base = std::max<long long>(0, i - W_);
+            for (long long x = t.base; x < i; ++x) {
+                const size_t k = static_cast<size_t>(x);
+                const size_t e = static_cast<size_t>(x - t.base);
+                const bool blocked = c_.boundaries && c_.boundaries->blocked(k);
+                t.DP[e] = blocked ? DpCosts<Cost>::unreachable() : static_cast<Cost>(tables_.DP[k] + shift);
+                if (primed) t.DPr[e] = blocked ? DpCosts<Cost>::unreachable() : static_cast<Cost>(tables_.DPr[k] + shift);
+            }
+        };
+        size_t next = 0;
+        long long i = changed.front();
+        load(i, 0);
+        for (;;) {
+            Cost shift = 0;
+            const long long stop = run(candidate, t, i, &tables_, &shift);
+            if (stop >= N_) return static_cast<double>(t.DP[static_cast<size_t>(N_ - t.base)]) / unit_;
+            if (stop == t.base + window - 1) {
+                // Out of window (parallel or not): keep its last W positions.
+                const size_t keep = static_cast<size_t>(window - W_);
+                std::copy(t.DP.begin() + static_cast<long long>(keep), t.DP.end(), t.DP.begin());
+                if (primed) std::copy(t.DPr.begin() + static_cast<long long>(keep), t.DPr.end(), t.DPr.begin());
+                t.base += static_cast<long long>(keep);
+                i = stop + 1;
+                continue;
+            }
+            while (next < changed.size() && changed[next] <= stop) ++next;
+            if (next == changed.size()) return static_cast<double>(tables_.DP[static_cast<size_t>(N_)] + shift) / unit_;
+            // Up to the next difference DP is the reference plus shift; the
+            // DP there reads the last W of those values.
+            i = changed[next];
+            load(i, shift);
+        }
+    }
+
+    void adopt(const ReuseProfile& candidate) override { run(candidate, tables_, 0, nullptr, nullptr); }
+
+private:
+    long long run(const ReuseProfile& reuse, DpTables<Cost>& t, long long from, const DpTables<Cost>* reference,
+                  Cost* shift) const {
+        if (c_.join != 0) return run_dp<Cost, true>(reuse, c_, 0, N_, 0, t, reference, shift, from);
+        return run_dp<Cost, false>(reuse, c_, 0, N_, 0, t, reference, shift, from);
+    }
+
+    // Declared in construction order: c_ points into terms_.
+    std::unique_ptr<SynthComplexity> complexity_;
+    RecordTerms terms_;
+    int W_;
+    double unit_;
+    long long N_;
+    DpCosts<Cost> c_;
+    DpTables<Cost> tables_;
+};
+
+template <typename Synth>
+std::unique_ptr<DpSession::Impl> make_dp_session(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                                                 const Synth& synth) {
+    std::unique_ptr<SynthComplexity> complexity;
+    RecordTerms terms = record_terms(seq, costs, reuse.W, complexity);
+    switch (dp_integer_bits(static_cast<long long>(seq.length()), reuse.W, costs, synth, terms)) {
+    case 32:
+        return std::make_unique<DpSessionOf<std::int32_t>>(reuse, costs, synth, std::move(terms), std::move(complexity), costs.scale);
+    case 64:
+        return std::make_unique<DpSessionOf<std::int64_t>>(reuse, costs, synth, std::move(terms), std::move(complexity), costs.scale);
+    default:
+        return std::make_unique<DpSessionOf<double>>(reuse, costs, synth, std::move(terms), std::move(complexity), 1.0);
+    }
+}
+
+} // namespace
+
+DpSession::DpSession(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs) {
+    if (!costs.synth_table.empty()) {
+        impl_ = make_dp_session(seq, reuse, costs, TabulatedSynth{costs.synth_table.data()});
+    } else if (costs.synth_quad != 0.0) {
+        impl_ = make_dp_session(seq, reuse, costs, QuadraticSynth{costs.synth_linear, costs.synth_quad});
+    } else {
+        impl_ = make_dp_session(seq, reuse, costs, LinearSynth{costs.synth_linear});
+    }
+}
+
+DpSession::~DpSession() = default;
+DpSession::DpSession(DpSession&&) noexcept = default;
+DpSession& DpSession::operator=(DpSession&&) noexcept = default;
+
+double DpSession::cost() const { return impl_->cost(); }
+double DpSession::evaluate(const ReuseProfile& candidate, const std::vector<long long>& changed) const {
+    return impl_->evaluate(candidate, changed);
+}
+void DpSession::adopt(const ReuseProfile& candidate) { impl_->adopt(candidate); }
+
+namespace {
+
+// The sequence a greedy planner walks: the record, or for a circular record
+// its extension from the first allowed cut at or after the origin, N bases on.
+struct GreedyRange {
+    std::string text;   // the circular extension (empty for a linear record)
+    long long first = 0;
+    long long end = 0;
+    long long origin = 0;
+};
+
+GreedyRange greedy_range(const std::string& chrom_seq, const CostModel& costs, int W) {
+    GreedyRange range;
+    range.end = static_cast<long long>(chrom_seq.length());
+    if (!costs.circular || chrom_seq.empty()) return range;
+    range.origin = circular_margin(costs, W);
+    range.text = circular_extension(chrom_seq, range.origin);
+    range.first = range.origin;
+    range.end = range.origin + static_cast<long long>(chrom_seq.length());
+    return range;
+}
+
+// PCR cost of the reusable fragment ending at i, from the cheapest source
+// holding it.
+double reuse_pcr_cost(const CostModel& costs, const ReuseProfile& reuse, size_t i, int f) {
+    const int tier = reuse.tier(i, f);
+    return costs.pcr_cost(f) + (tier >= 0 ? reuse.tier_pcr[static_cast<size_t>(tier)] - costs.pcr : 0.0);
+}
+
+// Moves a circular range to the first allowed cut (some lies within W bases).
+void skip_blocked_origin(GreedyRange& range, const BoundaryMask& boundaries, long long N, int W) {
+    if (range.text.empty()) return;
+    for (long long k = 0; k < std::min<long long>(W, N); ++k) {
+        if (!boundaries.blocked(static_cast<size_t>(range.origin + k))) {
+            range.first = range.origin + k;
+            range.end = range.first + N;
+            return;
+        }
+    }
+}
+
+} // namespace
+
+// Replication-First: take the longest reusable block starting at i (up to W bp,
+// or reuse_max); fall back to synthesising a single base if none of at least
+// reuse_min bp exists, or if it is repeated in the sources with unique_only
+// (every shorter block from i is then repeated too).  Blocks end at the
+// nearest allowed boundary: reused ones are shortened, synthesised ones
+// extended.  With an overlap o, a block from i > 0 is acquired as the fragment
+// starting at i - o, and the first block is at least o bp.  A circular record
+// is walked once around from the origin, every block joined to the one before.
+PlannerStats solve_greedy_for_chromosome_stats(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                               std::vector<PlanBlock>* blocks) {
+    PlannerStats stats;
+    if (blocks) blocks->clear();
+    const long long N = static_cast<long long>(chrom_seq.length());
+    stats.length = static_cast<std::uint64_t>(N);
+    if (N == 0) return stats;
+
+    GreedyRange range = greedy_range(chrom_seq, costs, reuse.W);
+    const std::string& seq = range.text.empty() ? chrom_seq : range.text;
+    const PrimerPenalties primers = primer_penalties(seq, costs.primer);
+    std::unique_ptr<SynthComplexity> complexity;
+    if (costs.synth_rules.enabled()) complexity.reset(new SynthComplexity(seq, costs.synth_rules));
+    const int o = costs.overlap;
+    const BoundaryMask boundaries = forbidden_boundaries(seq, costs.forbidden_motifs, reuse.W - o);
+    skip_blocked_origin(range, boundaries, N, reuse.W);
+    const long long end = range.end;
+    long long i = range.first;
+    while (i < end) {
+        const bool joined = i > range.first || costs.circular;
+        const long long from = joined ? i - o : i;   // fragment start
+        const int lead = static_cast<int>(i - from);
+        const int shortest = joined ? 1 : static_cast<int>(std::min<long long>(std::max(1, o), N));
+        int best_w = static_cast<int>(std::min<long long>(reuse.start_len[static_cast<size_t>(from)] - lead, end - i));
+        if (costs.reuse_max > 0) best_w = std::min(best_w, costs.reuse_max - lead);
+        while (best_w > 0 && i + best_w < end && boundaries.blocked(static_cast<size_t>(i + best_w))) --best_w;
+        if (best_w < shortest) best_w = 0;
+
+        const double cost_before = stats.cost;
+        const std::uint64_t start = static_cast<std::uint64_t>(i - range.origin);
+        stats.segments++;
+        if (joined) { stats.cost += costs.join; }
+
+        const int best_f = best_w + lead;
+        const bool repeated = best_w > 0 && reuse.repeated(static_cast<size_t>(i + best_w), best_f);
+        if (best_w > 0 && costs.reusable_length(best_f) && !(repeated && costs.unique_only)) {
+            stats.cost += reuse_pcr_cost(costs, reuse, static_cast<size_t>(i + best_w), best_f) + (repeated ? costs.multi_penalty : 0.0);
+            if (!primers.empty()) stats.cost += primers.block(static_cast<size_t>(from), static_cast<size_t>(i + best_w));
+            stats.reuse_moves++;
+            stats.reuse_bases += static_cast<std::uint64_t>(best_w);
+            if (blocks) blocks->push_back({start, static_cast<std::uint32_t>(best_w), true, stats.cost - cost_before});
+            i += best_w;
+        } else {
+            int synth_len = shortest;
+            while (i + synth_len < end && boundaries.blocked(static_cast<size_t>(i + synth_len))) ++synth_len;
+            // Nonlinear term has no effect for synth_len=1, but synth_len grows
+            // past forbidden boundaries and with the overlap.
+            stats.cost += costs.synth(synth_len + lead);
+            if (complexity) stats.cost += complexity->penalty(static_cast<size_t>(from), static_cast<size_t>(i + synth_len));
+            stats.synth_moves++;
+            stats.synth_bases += static_cast<std::uint64_t>(synth_len);
+            if (blocks) blocks->push_back({start, static_cast<std::uint32_t>(synth_len), false, stats.cost - cost_before});
+            i += synth_len;
+        }
+    }
+    stats.joins = costs.circular ? stats.segments : (stats.segments > 0 ? stats.segments - 1 : 0);
+    if (blocks && costs.circular) order_circular_blocks(*blocks, N);
+    return stats;
+}
+
+// Max-Block: always cut blocks of W bp (the last one may be shorter, or one
+// ending at a forbidden boundary is shortened to the nearest allowed one);
+// reuse a block if it occurs in the source (or, with mismatches, is within
+// max_mismatches substitutions of it), its length is reusable and PCR is not
+// more expensive than synthesis.  With an overlap o, blocks after the
+// first are acquired as fragments of up to W bp starting o bases early.  A
+// circular record is cut once around from the origin, every block joined.
+PlannerStats solve_max_block_greedy_for_chromosome_stats(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                                         std::vector<PlanBlock>* blocks) {
+    PlannerStats stats;
+    if (blocks) blocks->clear();
+    const long long N = static_cast<long long>(chrom_seq.length());
+    stats.length = static_cast<std::uint64_t>(N);
+    if (N == 0) return stats;
+
+    GreedyRange range = greedy_range(chrom_seq, costs, reuse.W);
+    const std::string& seq = range.text.empty() ? chrom_seq : range.text;
+    const PrimerPenalties primers = primer_penalties(seq, costs.primer);
+    std::unique_ptr<SynthComplexity> complexity;
+    if (costs.synth_rules.enabled()) complexity.reset(new SynthComplexity(seq, costs.synth_rules));
+    const int o = costs.overlap;
+    const BoundaryMask boundaries = forbidden_boundaries(seq, costs.forbidden_motifs, reuse.W - o);
+    skip_blocked_origin(range, boundaries, N, reuse.W);
+    const long long end = range.end;
+    long long i = range.first;
+    while (i < end) {
+        const bool joined = i > range.first || costs.circular;
+        const long long from = joined ? i - o : i;   // fragment start
+        const int lead = static_cast<int>(i - from);
+        int w = static_cast<int>(std::min<long long>(reuse.W - lead, end - i));
+        while (i + w < end && boundaries.blocked(static_cast<size_t>(i + w))) --w;
+        const int f = w + lead;
+        double cost_if_synth = costs.synth(f);
+        if (complexity) cost_if_synth += complexity->penalty(static_cast<size_t>(from), static_cast<size_t>(i + w));
+        const bool repeated = reuse.repeated(static_cast<size_t>(i + w), f);
+        const int mismatches = reuse.mismatches(static_cast<size_t>(i + w), f);
+        const bool can_reuse = mismatches >= 0 && costs.reusable_length(f) && !(repeated && costs.unique_only);
+        double cost_if_reuse = reuse_pcr_cost(costs, reuse, static_cast<size_t>(i + w), f) + (repeated ? costs.multi_penalty : 0.0) +
+                               mismatches * costs.mismatch_cost;
+        if (!primers.empty()) cost_if_reuse += primers.block(static_cast<size_t>(from), static_cast<size_t>(i + w));
+        const bool choose_reuse = can_reuse && cost_if_reuse <= cost_if_synth;
+
+        const double cost_before = stats.cost;
+        stats.segments++;
+        stats.cost += choose_reuse ? cost_if_reuse : cost_if_synth;
+        if (joined) { stats.cost += costs.join; }
+
+        if (choose_reuse) {
+            stats.reuse_moves++;
+            stats.reuse_bases += static_cast<std::uint64_t>(w);
+            stats.mismatches += static_cast<std::uint64_t>(mismatches);
+        } else {
+            stats.synth_moves++;
+            stats.synth_bases += static_cast<std::uint64_t>(w);
+        }
+        if (blocks) {
+            PlanBlock block{static_cast<std::uint64_t>(i - range.origin), static_cast<std::uint32_t>(w), choose_reuse,
+                            stats.cost - cost_before};
+            if (choose_reuse) block.mismatches = static_cast<std::uint8_t>(mismatches);
+            blocks->push_back(block);
+        }
+        i += w;
+    }
+    stats.joins = costs.circular ? stats.segments : (stats.segments > 0 ? stats.segments - 1 : 0);
+    if (blocks && costs.circular) order_circular_blocks(*blocks, N);
+    return stats;
+}
+
+namespace {
+
+// Runs a block planner and, with assembly levels, solves the levels over its
+// block boundaries, priced by the prefix sums of its block costs.
+template <typename Solve>
+PlannerStats plan_levels(const CostModel& costs, std::vector<PlanBlock>* blocks, Solve solve) {
+    if (costs.levels.empty()) return solve(blocks);
+    std::vector<PlanBlock> own;
+    std::vector<PlanBlock>& leaf = blocks ? *blocks : own;
+    PlannerStats stats = solve(&leaf);
+    if (!stats.planned) return stats;
+    // On a circle the levels run from the first cut once around.
+    std::vector<std::uint64_t> cuts(1, leaf.empty() ? 0 : leaf.front().start);
+    std::vector<double> prefix(1, 0.0);
+    for (const PlanBlock& block : leaf) {
+        cuts.push_back(block.start + block.length);
+        prefix.push_back(prefix.back() + block.cost);
+    }
+    std::vector<std::uint8_t> cut_level;
+    stats.cost = assemble_levels(cuts, prefix, costs.join, costs.levels, cut_level);
+    for (size_t k = 1; k < leaf.size(); ++k) leaf[k].level = cut_level[k];
+    return stats;
+}
+
+class DPPlanner : public Planner {
+public:
+    const char* name() const override { return "dp"; }
+    PlannerStats plan(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                      std::vector<PlanBlock>* blocks) const override {
+        return plan_levels(costs, blocks, [&](std::vector<PlanBlock>* out) { return solve_dp_for_chromosome(seq, reuse, costs, out); });
+    }
+};
+
+class GreedyPlanner : public Planner {
+public:
+    const char* name() const override { return "greedy"; }
+    PlannerStats plan(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                      std::vector<PlanBlock>* blocks) const override {
+        return plan_levels(costs, blocks, [&](std::vector<PlanBlock>* out) {
+            return solve_greedy_for_chromosome_stats(seq, reuse, costs, out);
+        });
+    }
+};
+
+class MaxBlockPlanner : public Planner {
+public:
+    const char* name() const override { return "maxblock"; }
+    PlannerStats plan(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                      std::vector<PlanBlock>* blocks) const override {
+        return plan_levels(costs, blocks, [&](std::vector<PlanBlock>* out) {
+            return solve_max_block_greedy_for_chromosome_stats(seq, reuse, costs, out);
+        });
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Planner> make_planner(const std::string& name) {
+    if (name == "dp") return std::make_unique<DPPlanner>();
+    if (name == "greedy") return std::make_unique<GreedyPlanner>();
+    if (name == "maxblock") return std::make_unique<MaxBlockPlanner>();
+    return nullptr;
+}
+
+std::vector<std::string> planner_names() {
+    return {"dp", "greedy", "maxblock"};
+}
+
+// --- COMMAND LINE ---
+
+// "LO,HI" (or "LO:HI") with LO <= HI.
+static bool parse_range(const std::string& text, double& lo, double& hi) {
+    const size_t sep = text.find_first_of(",:");
+    if (sep == std::string::npos) return false;
+    try {
+        size_t used_lo = 0, used_hi = 0;
+        const double l = std::stod(text.substr(0, sep), &used_lo);
+        const double h = std::stod(text.substr(sep + 1), &used_hi);
+        if (used_lo != sep || used_hi != text.size() - sep - 1 || l > h) return false;
+        lo = l;
+        hi = h;
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+bool parse_price_list(const std::string& text, std::vector<double>& prices) {
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            size_t used = 0;
+            prices.push_back(std::stod(item, &used));
+            if (used != item.size()) return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return !prices.empty();
+}
+
+bool parse_planner_args(int argc, char* argv[], int first, PlannerArgs& out) {
+    int a = first;
+    std::string synth_table_path;
+    while (a < argc && std::string(argv[a]).rfind("--", 0) == 0) {
+        const std::string opt = argv[a];
+        if (opt == "--regions" && a + 1 < argc) {
+            out.regions = argv[a + 1];
+            a += 2;
+        } else if (opt == "--split-gaps") {
+            out.split_gaps = true;
+            ++a;
+        } else if (opt == "--cost-scale" && a + 1 < argc) {
+            try {
+                out.costs.scale = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                out.costs.scale = -1.0;
+            }
+            if (!(out.costs.scale > 0.0)) {
+                std::cerr << "ERROR: --cost-scale must be a positive number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--synth-table" && a + 1 < argc) {
+            synth_table_path = argv[a + 1];
+            a += 2;
+        } else if ((opt == "--reuse-min" || opt == "--reuse-max") && a + 1 < argc) {
+            int& length = (opt == "--reuse-min") ? out.costs.reuse_min : out.costs.reuse_max;
+            try {
+                length = std::stoi(argv[a + 1]);
+            } catch (const std::exception&) {
+                length = -1;
+            }
+            if (length < 0 || length > kMaxBlockLen) {
+                std::cerr << "ERROR: " << opt << " must be in [0, " << kMaxBlockLen << "]" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--multi-penalty" && a + 1 < argc) {
+            try {
+                out.costs.multi_penalty = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                std::cerr << "ERROR: --multi-penalty must be a number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--primer-len" && a + 1 < argc) {
+            try {
+                out.costs.primer.length = std::stoi(argv[a + 1]);
+            } catch (const std::exception&) {
+                out.costs.primer.length = -1;
+            }
+            if (out.costs.primer.length < 0 || out.costs.primer.length > kMaxBlockLen) {
+                std::cerr << "ERROR: --primer-len must be in [0, " << kMaxBlockLen << "]" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if ((opt == "--primer-gc" || opt == "--primer-tm") && a + 1 < argc) {
+            double& lo = (opt == "--primer-gc") ? out.costs.primer.gc_min : out.costs.primer.tm_min;
+            double& hi = (opt == "--primer-gc") ? out.costs.primer.gc_max : out.costs.primer.tm_max;
+            if (!parse_range(argv[a + 1], lo, hi)) {
+                std::cerr << "ERROR: " << opt << " expects LO,HI with LO <= HI" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--primer-penalty" && a + 1 < argc) {
+            try {
+                out.costs.primer.penalty = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                std::cerr << "ERROR: --primer-penalty must be a number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if ((opt == "--synth-homopolymer" || opt == "--synth-repeat") && a + 1 < argc) {
+            int& limit = (opt == "--synth-homopolymer") ? out.costs.synth_rules.max_homopolymer : out.costs.synth_rules.max_repeat;
+            try {
+                limit = std::stoi(argv[a + 1]);
+            } catch (const std::exception&) {
+                limit = -1;
+            }
+            if (limit < 0) {
+                std::cerr << "ERROR: " << opt << " must be a non-negative length" << std::endl;
+                return false;
+            }
+            if (opt == "--synth-repeat" && limit < out.costs.synth_rules.min_repeat_limit()) {
+                std::cerr << "ERROR: --synth-repeat must be at least " << out.costs.synth_rules.min_repeat_limit() << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--synth-gc" && a + 1 < argc) {
+            if (!parse_range(argv[a + 1], out.costs.synth_rules.gc_min, out.costs.synth_rules.gc_max)) {
+                std::cerr << "ERROR: --synth-gc expects LO,HI with LO <= HI" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--synth-penalty" && a + 1 < argc) {
+            try {
+                out.costs.synth_rules.penalty = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                out.costs.synth_rules.penalty = -1.0;
+            }
+            if (out.costs.synth_rules.penalty < 0.0) {
+                std::cerr << "ERROR: --synth-penalty must be a non-negative number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--forbid-motifs" && a + 1 < argc) {
+            if (!load_motifs(argv[a + 1], out.costs.forbidden_motifs)) return false;
+            a += 2;
+        } else if (opt == "--forbid-motif" && a + 1 < argc) {
+            if (!parse_motif_list(argv[a + 1], out.costs.forbidden_motifs)) {
+                std::cerr << "ERROR: --forbid-motif expects comma-separated A/C/G/T motifs" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--overlap" && a + 1 < argc) {
+            try {
+                out.costs.overlap = std::stoi(argv[a + 1]);
+            } catch (const std::exception&) {
+                out.costs.overlap = -1;
+            }
+            if (out.costs.overlap < 0) {
+                std::cerr << "ERROR: --overlap must be a non-negative length" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--levels" && a + 1 < argc) {
+            if (!parse_assembly_levels(argv[a + 1], out.costs.levels)) {
+                std::cerr << "ERROR: --levels expects LEN:JOIN[,LEN:JOIN...] with LEN increasing" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--circular") {
+            out.costs.circular = true;
+            ++a;
+        } else if (opt == "--self-reuse") {
+            out.costs.self_reuse = true;
+            ++a;
+        } else if (opt == "--mismatches" && a + 1 < argc) {
+            try {
+                out.costs.max_mismatches = std::stoi(argv[a + 1]);
+            } catch (const std::exception&) {
+                out.costs.max_mismatches = -1;
+            }
+            if (out.costs.max_mismatches < 0 || out.costs.max_mismatches > kMaxMismatches) {
+                std::cerr << "ERROR: --mismatches must be in [0, " << kMaxMismatches << "]" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--mismatch-cost" && a + 1 < argc) {
+            try {
+                out.costs.mismatch_cost = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                std::cerr << "ERROR: --mismatch-cost must be a number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--source-pcr" && a + 1 < argc) {
+            if (!parse_price_list(argv[a + 1], out.costs.source_pcr)) {
+                std::cerr << "ERROR: --source-pcr expects a comma-separated list of prices" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else if (opt == "--unique-only") {
+            out.costs.unique_only = true;
+            ++a;
+        } else if (opt == "--pcr-per-base" && a + 1 < argc) {
+            try {
+                out.costs.pcr_per_base = std::stod(argv[a + 1]);
+            } catch (const std::exception&) {
+                std::cerr << "ERROR: --pcr-per-base must be a number" << std::endl;
+                return false;
+            }
+            a += 2;
+        } else {
+            std::cerr << "ERROR: Unknown option '" << opt << "' (use --help for details)" << std::endl;
+            return false;
+        }
+    }
+    const int n = argc - a;
+    if (n != 6 && n != 7) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <source_index.fm>"
+                  << "  (use --help for details)" << std::endl;
+        return false;
+    }
+    char** pos = argv + a;
+    try {
+        out.W = std::stoi(pos[0]);
+        out.fasta_path = pos[1];
+        out.costs.pcr = std::stod(pos[2]);
+        out.costs.join = std::stod(pos[3]);
+        out.costs.synth_linear = std::stod(pos[4]);
+        out.costs.synth_quad = 0.0;
+        if (n == 6) {
+            out.index_path = pos[5];
+        } else {
+            out.costs.synth_quad = std::stod(pos[5]);
+            out.index_path = pos[6];
+        }
+    } catch (const std::exception&) {
+        std::cerr << "ERROR: Could not parse numeric arguments (use --help for details)" << std::endl;
+        return false;
+    }
+    if (out.W < 1 || out.W > kMaxBlockLen) {
+        std::cerr << "ERROR: W must be in [1, " << kMaxBlockLen << "]" << std::endl;
+        return false;
+    }
+    if (out.costs.overlap >= out.W) {
+        std::cerr << "ERROR: --overlap (" << out.costs.overlap << ") must be below W (" << out.W << ")" << std::endl;
+        return false;
+    }
+    if (!out.costs.levels.empty() && out.costs.levels.front().max_len < out.W) {
+        std::cerr << "ERROR: --levels: the first level (" << out.costs.levels.front().max_len
+                  << " bp) must hold a block of W (" << out.W << ") bp" << std::endl;
+        return false;
+    }
+    if (out.costs.circular && (!out.regions.empty() || out.split_gaps)) {
+        std::cerr << "ERROR: --circular plans whole records; it cannot be combined with --regions or --split-gaps" << std::endl;
+        return false;
+    }
+    if (out.costs.circular && out.costs.self_reuse) {
+        std::cerr << "ERROR: --self-reuse needs a linear record; it cannot be combined with --circular" << std::endl;
+        return false;
+    }
+    if (out.costs.reuse_min < 1) out.costs.reuse_min = 1;
+    if (out.costs.reuse_max > 0 && out.costs.reuse_max < out.costs.reuse_min) {
+        std::cerr << "ERROR: --reuse-max (" << out.costs.reuse_max << ") is below --reuse-min ("
+                  << out.costs.reuse_min << ")" << std::endl;
+        return false;
+    }
+    if (!synth_table_path.empty()) {
+        if (!load_synth_table(synth_table_path, out.costs.synth_table)) return false;
+        const int longest = static_cast<int>(out.costs.synth_table.size()) - 1;
+        if (longest < out.W) {
+            std::cerr << "ERROR: Synthesis price table stops at " << longest << " bp but W is " << out.W << std::endl;
+            return false;
+        }
+    }
+    if (out.costs.scale > 0.0) {
+        auto whole = [&out](double x) {
+            const double u = x * out.costs.scale;
+            return std::fabs(u - std::round(u)) <= 1e-9 * std::max(1.0, std::fabs(u));
+        };
+        bool exact = whole(out.costs.pcr) && whole(out.costs.join) && whole(out.costs.synth_linear) && whole(out.costs.synth_quad) &&
+                     whole(out.costs.pcr_per_base) && whole(out.costs.multi_penalty) && whole(out.costs.mismatch_cost);
+        for (const double price : out.costs.synth_table) exact = exact && whole(price);
+        for (const double price : out.costs.source_pcr) exact = exact && whole(price);
+        if (!exact) {
+            std::cerr << "WARNING: Costs are not whole multiples of 1/" << out.costs.scale
+                      << "; each block cost is rounded to the nearest unit" << std::endl;
+        }
+    }
+    return true;
+}
+
+const char* planner_options_help() {
+    return "Options (before the positional arguments):\n"
+           "  --regions R      Plan only these loci instead of every record.  R is a BED file\n"
+           "                   (chrom, start, end[, name]; 0-based) or a comma-separated list\n"
+           "                   of chrom or chrom:start-end (1-based, inclusive).  Needs an\n"
+           "                   uncompressed target.fasta with a .fai (samtools faidx); only\n"
+           "                   the requested bytes are read.  Regions are planned in parallel\n"
+           "                   (OpenMP, see OMP_NUM_THREADS).\n"
+           "  --split-gaps     Keep N runs and IUPAC codes (R, Y, ...) as gaps instead of\n"
+           "                   dropping them.  Each record is cut into its gap-free segments,\n"
+           "                   which are planned independently and in parallel; rows are\n"
+           "                   labelled chrom:start-end in 1-based record coordinates and no\n"
+           "                   block ever spans a gap.  Without it non-ACGT characters are\n"
+           "                   deleted and the flanks are planned as one sequence.\n"
+           "  --cost-scale S   Run the DP in integer units of 1/S (e.g. 100 for costs in\n"
+           "                   cents).  Block costs are rounded to whole units, sums are\n"
+           "                   exact and equal-cost plans are broken the same way on every\n"
+           "                   machine.  State is int32 when a record cannot overflow it\n"
+           "                   (half the memory, twice the SIMD lanes), int64 otherwise.\n"
+           "                   The greedy planners are unaffected.\n"
+           "  --synth-table F  Price synthesis from a table instead of synth_linear/synth_quad\n"
+           "                   (which must still be given, and are ignored).  F has one\n"
+           "                   '<length> <cost>' row per price bracket, lengths increasing;\n"
+           "                   a row prices every length above the previous row up to its\n"
+           "                   own.  The table must reach W.  Used by every planner.\n"
+           "  --reuse-min L    Only reuse blocks of at least L bp (shorter amplicons are not\n"
+           "                   specific enough to prime); shorter stretches are synthesised.\n"
+           "                   The source search skips ahead past any L-bp window that\n"
+           "                   cannot match, so large L also speeds up the reuse profile.\n"
+           "  --reuse-max L    Only reuse blocks of at most L bp (longest reliable PCR\n"
+           "                   product).  0 (default) means W.\n"
+           "  --pcr-per-base X Add X per reused base to the PCR cost: a reused block of L bp\n"
+           "                   costs pcr + X * L.  Default 0.  Used by every planner.\n"
+           "  --multi-penalty X Add X to the cost of reusing a block that occurs more than\n"
+           "                   once in the source indexes (PCR may amplify the wrong copy).\n"
+           "                   Occurrences are the suffix array interval widths of the\n"
+           "                   reuse search itself, so no extra index pass is made.\n"
+           "  --unique-only    Never reuse a block that occurs more than once; it is\n"
+           "                   synthesised (or split) instead.\n"
+           "  --primer-len P   Score the primer sites of every reused block: the first and\n"
+           "                   last P bases must have GC content and nearest-neighbour Tm\n"
+           "                   (SantaLucia 1998, 50 mM Na+, 250 nM primer) in range.  Each\n"
+           "                   site costs X per percentage point / degree outside.  Sites\n"
+           "                   come from prefix sums over the record (O(1) per block), so\n"
+           "                   the DP optimises primer quality at negligible extra cost.\n"
+           "                   Blocks shorter than P are scored on windows reaching past\n"
+           "                   them; combine with --reuse-min P.  Default 0 (off).\n"
+           "  --primer-gc LO,HI   Acceptable primer GC content in percent (default 40,60).\n"
+           "  --primer-tm LO,HI   Acceptable primer Tm in degrees C (default 52,62).\n"
+           "  --primer-penalty X  Cost per unit outside the ranges (default 1).\n"
+           "  --synth-penalty X   Charge synthesised blocks X per unit of sequence\n"
+           "                   complexity: per GC percentage point outside --synth-gc\n"
+           "                   (blocks of 50 bp or more), per base of the longest\n"
+           "                   homopolymer beyond --synth-homopolymer, and per base of the\n"
+           "                   longest tandem repeat (unit 2-6 bp) beyond --synth-repeat.\n"
+           "                   Each block is scored in O(1) from run-length tables, so the\n"
+           "                   DP prefers orderable fragments.  Default 0 (off).\n"
+           "  --forbid-motifs F   No block boundary inside a forbidden motif (e.g. the BsaI\n"
+           "                   and BsmBI sites GGTCTC, CGTCTC) or its reverse complement.\n"
+           "                   F has one motif per line, optionally after a name.  One\n"
+           "                   Aho-Corasick pass per record marks the forbidden boundaries;\n"
+           "                   the DP never ends a block there and the greedy planners move\n"
+           "                   their cuts to the nearest allowed boundary.  Motif runs too\n"
+           "                   long for one block are cut every W bases.\n"
+           "  --forbid-motif SEQ[,SEQ...]  The same, given on the command line.\n"
+           "  --overlap L      Gibson/HiFi assembly: every block after the first is\n"
+           "                   acquired with the L bases before it, i.e. the fragment\n"
+           "                   [j - L, i) of at most W bp is synthesised or amplified for\n"
+           "                   the segment [j, i).  Prices, reuse limits, primer sites and\n"
+           "                   complexity refer to the fragment, which is reusable iff it\n"
+           "                   occurs in the source: the reuse profile already answers\n"
+           "                   that, so no extra index queries are made.  Default 0.\n"
+           "  --levels LEN:JOIN[,LEN:JOIN...]  Hierarchical assembly: blocks are joined\n"
+           "                   into units of at most LEN bp, those into the units of the\n"
+           "                   next level, and so on; a junction between two units costs\n"
+           "                   that level's JOIN instead of the block join (e.g.\n"
+           "                   10000:50,100000:500).  All levels are solved together\n"
+           "                   over the planner's block boundaries (exact for its blocks);\n"
+           "                   when that would table too many units (dense blocks under\n"
+           "                   long levels) they are solved one at a time, with a warning.\n"
+           "                   Applies to every planner.\n"
+           "  --circular       Every record is circular (plasmid, bacterial chromosome):\n"
+           "                   one block may run across the origin and the junction that\n"
+           "                   closes the circle is charged like any other.  The reuse\n"
+           "                   profile is computed on the record extended around the\n"
+           "                   origin, so wrapped blocks are looked up like all others.\n"
+           "                   The DP is exact without planning every rotation: the plan\n"
+           "                   from each first cut in [0, W) is only followed until it\n"
+           "                   runs parallel to the plan from cut 0.  The greedy planners\n"
+           "                   walk once around from the origin.  Index circular sources\n"
+           "                   with create_index --circular.\n"
+           "  --self-reuse     A block may also be amplified from an earlier copy in the\n"
+           "                   same record (segmental duplications, repeated operons):\n"
+           "                   the copy must end before the block starts, so it is built\n"
+           "                   first.  A suffix automaton of each record finds the longest\n"
+           "                   such block ending at every position in O(N) (about 64 bytes\n"
+           "                   per base while the profile is built), merged into the same\n"
+           "                   reuse profile as the source, so every planner uses it.\n"
+           "                   Not with --circular.\n"
+           "  --mismatches K   Mutagenic PCR: a block within K substitutions (K <= 3) of a\n"
+           "                   source string is amplified and corrected by site-directed\n"
+           "                   mutagenesis for the PCR cost plus --mismatch-cost X per\n"
+           "                   substitution.  The reuse profile gains the longest such\n"
+           "                   block per end and mismatch count, from a backtracking\n"
+           "                   search over the index bounded by the previous position's\n"
+           "                   lengths; the DP offers each mismatch run next to synthesis\n"
+           "                   and max-block compares it with synthesis; replication-first\n"
+           "                   keeps to exact copies.  Default 0.\n"
+           "  --source-pcr P[,P...]  With a comma-separated list of source indexes (a donor\n"
+           "                   panel, e.g. a.fm,b.fm,c.fm), the PCR price of each, replacing\n"
+           "                   pcr for blocks amplified from it; a block found in several\n"
+           "                   donors costs the cheapest.  Every index is searched on its\n"
+           "                   own with the same incremental backward search, in parallel,\n"
+           "                   and the profile keeps the longest match per price tier, so\n"
+           "                   the DP cuts its reuse run where the cheapest donor changes.\n"
+           "                   A panel index from create_index a.fa,b.fa,... takes one\n"
+           "                   price per donor (every donor of it in turn in the list):\n"
+           "                   its colour file gives the donors of each suffix array\n"
+           "                   interval and a range-minimum query their cheapest price,\n"
+           "                   so the panel is one search whatever its size.  Self-reuse\n"
+           "                   copies and mutagenic blocks cost pcr.  Without it every\n"
+           "                   donor costs pcr.\n"
+           "  --synth-gc LO,HI    Acceptable GC content in percent (default 25,75).\n"
+           "  --synth-homopolymer H  Longest acceptable homopolymer (default 8).\n"
+           "  --synth-repeat R    Longest acceptable tandem repeat (default 16, at least 11).\n";
+}
+
+namespace {
+
+struct RecordResult {
+    std::string name;
+    std::uint64_t length = 0;
+    std::vector<PlannerStats> stats;
+};
+
+RecordResult plan_record(const std::string& name, const std::string& seq, const PlannerArgs& args,
+                         const SourceIndex& source, const std::vector<const Planner*>& planners) {
+    RecordResult result;
+    result.name = sanitize_header(name);
+    result.length = seq.length();
+    const ReuseProfile reuse = compute_plan_profile(seq, args.W, source, args.costs);
+    for (const Planner* planner : planners) {
+        result.stats.push_back(planner->plan(seq, reuse, args.costs));
+    }
+    return result;
+}
+
+// Returns false if a planner found no plan for the record, which is
+// reported instead of a row and left out of the totals.
+bool print_record(const std::string& filename, const RecordResult& result,
+                  const std::vector<const Planner*>& planners, std::vector<PlannerStats>& totals) {
+    const bool prefixed = planners.size() > 1;
+    bool planned = true;
+    for (size_t p = 0; p < planners.size(); ++p) {
+        if (!result.stats[p].planned) {
+            std::cerr << "ERROR: No " << planners[p]->name() << " plan for " << result.name
+                      << ": every block boundary of the circular record is inside a forbidden motif" << std::endl;
+            planned = false;
+            continue;
+        }
+        // Output in CSV format
+        if (prefixed) std::cout << planners[p]->name() << ",";
+        std::cout << filename << ","
+                  << result.name << ","
+                  << result.length << ","
+                  << result.stats[p].cost << std::endl;
+        totals[p].accumulate(result.stats[p]);
+    }
+    return planned;
+}
+
+std::string region_label(const Region& r) {
+    if (!r.name.empty()) return r.name;
+    if (r.start == 0 && r.end == 0) return r.chrom;
+    return r.chrom + ":" + std::to_string(r.start + 1) + "-" + std::to_string(r.end);
+}
+
+// One row of output: [begin, end) of a cleaned sequence.
+struct PlanUnit {
+    std::string label;
+    const std::string* seq = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Appends the units for one record or region.  Without split_gaps that is
+// the whole sequence under `label`; otherwise one unit per gap-free segment,
+// labelled chrom:start-end with `offset` added to get record coordinates.
+void add_units(const std::string& label, const std::string& chrom, std::uint64_t offset, const std::string& seq,
+               bool split_gaps, std::vector<PlanUnit>& units) {
+    if (!split_gaps) {
+        units.push_back({label, &seq, 0, seq.size()});
+        return;
+    }
+    for (const Segment& segment : gap_free_segments(seq)) {
+        units.push_back({chrom + ":" + std::to_string(offset + segment.start + 1) + "-" + std::to_string(offset + segment.end),
+                         &seq, segment.start, segment.end});
+    }
+}
+
+// Plans every unit in parallel; results come back in unit order.
+std::vector<RecordResult> plan_units(const std::vector<PlanUnit>& units, const PlannerArgs& args,
+                                     const SourceIndex& source, const std::vector<const Planner*>& planners) {
+    std::vector<RecordResult> results(units.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long u = 0; u < static_cast<long long>(units.size()); ++u) {
+        const PlanUnit& unit = units[static_cast<size_t>(u)];
+        if (unit.begin == 0 && unit.end == unit.seq->size()) {
+            results[static_cast<size_t>(u)] = plan_record(unit.label, *unit.seq, args, source, planners);
+        } else {
+            results[static_cast<size_t>(u)] = plan_record(unit.label, unit.seq->substr(unit.begin, unit.end - unit.begin),
+                                                          args, source, planners);
+        }
+    }
+    return results;
+}
+
+// Fetches and plans every region; results come back in region order.
+bool plan_regions(const PlannerArgs& args, const SourceIndex& source, const std::vector<const Planner*>& planners,
+                  std::vector<RecordResult>& results) {
+    std::vector<Region> regions;
+    if (!parse_regions(args.regions, regions)) return false;
+    IndexedFasta fasta;
+    if (!fasta.open(args.fasta_path)) return false;
+
+    std::vector<std::string> seqs(regions.size());
+    std::vector<char> ok(regions.size(), 1);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long r = 0; r < static_cast<long long>(regions.size()); ++r) {
+        if (!fasta.fetch(regions[static_cast<size_t>(r)], seqs[static_cast<size_t>(r)], args.split_gaps)) {
+            ok[static_cast<size_t>(r)] = 0;
+        }
+    }
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) return false;
+
+    std::vector<PlanUnit> units;
+    for (size_t r = 0; r < regions.size(); ++r) {
+        add_units(region_label(regions[r]), regions[r].chrom, regions[r].start, seqs[r], args.split_gaps, units);
+    }
+    results = plan_units(units, args, source, planners);
+    return true;
+}
+
+} // namespace
+
+int run_planners(const PlannerArgs& args, const std::vector<const Planner*>& planners) {
+    SourceIndex source;
+    if (!load_source_index(args.index_path, source)) { return 1; }
+    if (!args.costs.source_pcr.empty() && args.costs.source_pcr.size() != source.donors()) {
+        std::cerr << "ERROR: --source-pcr gives " << args.costs.source_pcr.size() << " prices for " << source.donors()
+                  << " source donors" << std::endl;
+        return 1;
+    }
+
+    const std::string filename = fs::path(args.fasta_path).filename().string();
+    std::vector<PlannerStats> totals(planners.size());
+    bool planned = true;   // every record planned; otherwise the run fails after the totals
+
+    if (!args.regions.empty()) {
+        std::vector<RecordResult> results;
+        if (!plan_regions(args, source, planners, results)) { return 1; }
+        for (const RecordResult& result : results) {
+            if (result.length == 0) continue;
+            planned = print_record(filename, result, planners, totals) && planned;
+        }
+    } else {
+        PrefetchFastaReader reader(args.fasta_path, 0, args.split_gaps);
+        if (!reader.is_open()) {
+            std::cerr << "ERROR: Could not open FASTA file: " << args.fasta_path << std::endl;
+            return 1;
+        }
+        FastaRecord rec;
+        std::vector<PlanUnit> units;
+        while (reader.next(rec)) {
+            if (rec.seq.empty()) continue;
+            if (!args.split_gaps) {
+                planned = print_record(filename, plan_record(rec.header, rec.seq, args, source, planners), planners, totals) && planned;
+                continue;
+            }
+            units.clear();
+            add_units(rec.header, rec.header.substr(0, rec.header.find_first_of(" \t")), 0, rec.seq, true, units);
+            for (const RecordResult& result : plan_units(units, args, source, planners)) {
+                planned = print_record(filename, result, planners, totals) && planned;
+            }
+        }
+        if (reader.failed()) { return 1; }
+    }
+
+    const bool prefixed = planners.size() > 1;
+    for (size_t p = 0; p < planners.size(); ++p) {
+        const PlannerStats& total = totals[p];
+        // Stats line intended for scripts to parse (not CSV of same schema).
+        std::cout << "STATS_TOTAL,";
+        if (prefixed) std::cout << planners[p]->name() << ",";
+        std::cout << total.reuse_moves << ","
+                  << total.synth_moves << ","
+                  << total.joins << ","
+                  << total.segments << ","
+                  << total.reuse_bases << ","
+                  << total.synth_bases
+                  << std::endl;
+
+        // Final TOTAL line keeps the historical 4-column CSV schema and is last.
+        if (prefixed) std::cout << planners[p]->name() << ",";
+        std::cout << filename << ",TOTAL,"
+                  << total.length << "," << total.cost << std::endl;
+    }
+    return planned ? 0 : 1;
+}
@@ -0,0 +1,399 @@
+#pragma once
+// Shared planning library used by every planner binary.
+//
+//   SourceIndex   – handle over the loaded FM-index(es) of the source genome
+//   FastaReader   – target source (cleaned ACGT records, see fasta_reader.hpp)
+//   CostModel     – reuse / join / synthesis costs
+//   ReuseProfile  – per-position reuse lengths, computed once per record and
+//                   shared by all planners
+//   Planner       – common interface of the DP and greedy planners
+//   DpSession     – DP cost of one record re-solved across similar profiles
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <variant>
+#include <sdsl/csa_wt.hpp>
+#include <sdsl/suffix_arrays.hpp>
+#include "assembly_levels.hpp"
+#include "donor_colors.hpp"
+#include "fasta_reader.hpp"
+#include "junction_motifs.hpp"
+#include "primer_model.hpp"
+#include "r_index.hpp"
+#include "self_reuse.hpp"
+#include "synth_complexity.hpp"
+
+using fm_index_t = sdsl::csa_wt<sdsl::wt_huff<sdsl::bit_vector_il<256>>, 512, 1024>;
+// One index file: an FM-index, or a run-length BWT for highly repetitive
+// sources (create_index --r-index).  Both answer the same backward-search
+// steps over the same suffix array order.
+using text_index_t = std::variant<fm_index_t, RIndex>;
+
+// Block lengths are stored as uint16_t in the DP backtracking arrays.
+constexpr int kMaxBlockLen = 65535;
+// The mismatch search backtracks over 3^K substitutions per position.
+constexpr int kMaxMismatches = 3;
+
+// --- STATS ---
+
+struct PlannerStats {
+    double cost = 0.0;
+    std::uint64_t reuse_moves = 0;
+    std::uint64_t synth_moves = 0;
+    std::uint64_t joins = 0;
+    std::uint64_t segments = 0;
+    std::uint64_t reuse_bases = 0;
+    std::uint64_t synth_bases = 0;
+    std::uint64_t length = 0;
+    std::uint64_t mismatches = 0;   // substitutions corrected in mutagenic PCR blocks
+    // False when no plan exists: every block boundary of a short circular
+    // record falls inside a forbidden motif.  Nothing else is set then.
+    bool planned = true;
+
+    void accumulate(const PlannerStats& other);
+};
+
+using GreedyStats = PlannerStats;
+
+// --- INDEX HANDLE ---
+
+struct SourceIndex {
+    std::string path;
+    std::vector<text_index_t> indexes;
+    // Per index: the donor colours of a generalized panel index, or null.
+    std::vector<std::unique_ptr<DonorColors>> colors;
+
+    bool empty() const { return indexes.empty(); }
+    // Donors in load order: one per plain index, every colour of a panel index.
+    size_t donors() const;
+    // Their names: the file of a plain index, the colour names of a panel.
+    std::vector<std::string> donor_names() const;
+};
+
+// index_path is one index file or a comma-separated list of them (a donor
+// panel), loaded in that order, each with its colour file if it has one.
+// Each file may be an FM-index or an r-index.
+bool load_source_index(const std::string& index_path, SourceIndex& out);
+std::vector<text_index_t> load_single_index(const std::string& index_path);
+// Length of the indexed text, sentinel included.
+std::uint64_t index_size(const text_index_t& index);
+bool query_kmer(const std::string& kmer, const std::vector<text_index_t>& indexes);
+
+// --- COST MODEL ---
+
+struct CostModel {
+    double pcr = 0.0;
+    double join = 0.0;
+    double synth_linear = 0.0;
+    double synth_quad = 0.0;
+    // > 0: the DP planner works in integer units of 1 / scale (e.g. 100 for
+    // cents).  Each block cost is rounded to whole units, sums are exact and
+    // ties are decided by the plan, not by rounding order.  The DP uses
+    // int32 state when the record cannot overflow it, int64 otherwise.
+    double scale = 0.0;
+    // Optional per-length synthesis price (index = block length, entry 0
+    // unused).  When set it replaces synth_linear / synth_quad.
+    std::vector<double> synth_table;
+    // Reuse limits: a PCR block needs primer sites, so blocks shorter than
+    // reuse_min are never reused, nor blocks longer than reuse_max (0 = W).
+    // A reused block of L bases costs pcr + pcr_per_base * L.
+    int reuse_min = 1;
+    int reuse_max = 0;
+    double pcr_per_base = 0.0;
+    // Specificity: a reused block that occurs more than once in the sources
+    // can amplify the wrong copy.  Such blocks cost multi_penalty on top of
+    // the PCR cost, or are not reused at all with unique_only.
+    double multi_penalty = 0.0;
+    bool unique_only = false;
+
+    // Primer-site GC / Tm penalties added to every reused block (off unless
+    // primer.length > 0).
+    PrimerRules primer;
+    // Complexity penalties (GC, homopolymers, tandem repeats) added to every
+    // synthesised block (off unless synth_rules.penalty > 0).
+    SynthRules synth_rules;
+    // No block boundary may fall inside an occurrence of one of these motifs
+    // or of its reverse complement (forbidden_boundaries).
+    std::vector<std::string> forbidden_motifs;
+    // Gibson-style overlap: a block [j, i) with j > 0 is acquired as the
+    // fragment [j - overlap, i), which prices, limits and reuse apply to.
+    // Fragments are at most W bp; overlap < W.
+    int overlap = 0;
+    // Hierarchical assembly: blocks form units of at most levels[0].max_len
+    // bp, those units larger ones, and so on, each level with its own join
+    // cost (assemble_levels).  Empty = a flat partition.
+    std::vector<AssemblyLevel> levels;
+    // Circular records (plasmids, bacterial chromosomes): the plan is a cycle
+    // of blocks, one of which may run across the origin, and every junction
+    // is charged, including the one closing the circle, so k blocks pay k
+    // joins.  The reuse profile is that of the circular extension
+    // (compute_plan_profile).
+    bool circular = false;
+    // Self-reuse: a block may also be amplified from an earlier copy in the
+    // same record, which is built before it (add_self_reuse).  Linear
+    // records only.
+    bool self_reuse = false;
+    // Mutagenic PCR: a block within max_mismatches substitutions of a source
+    // string (and not an exact copy) is amplified and then corrected by
+    // site-directed mutagenesis, for pcr_cost plus mismatch_cost per
+    // substitution.  Occurrence rules apply to exact copies only.
+    int max_mismatches = 0;
+    double mismatch_cost = 0.0;
+    // Per-source PCR prices, one per donor of the source (SourceIndex::donors),
+    // replacing pcr for blocks amplified from that donor; a block present in
+    // several is priced by the cheapest.  Empty = every donor costs pcr.
+    // Self-reuse copies and mutagenic blocks keep pcr.
+    std::vector<double> source_pcr;
+    // A reusable block may also be synthesised where that is cheaper, so an
+    // extra source never raises the cost of a plan.  Off in the planners,
+    // which amplify every block a source holds; donor selection turns it on
+    // (a donor in stock is not a donor that must be used).
+    bool synth_reusable = false;
+
+    bool counts_occurrences() const { return unique_only || multi_penalty != 0.0; }
+    double pcr_cost(int length) const { return pcr + pcr_per_base * static_cast<double>(length); }
+    bool reusable_length(int length) const { return length >= reuse_min && (reuse_max == 0 || length <= reuse_max); }
+
+    double synth(int length) const {
+        if (!synth_table.empty()) return synth_table[static_cast<size_t>(length)];
+        const double x = static_cast<double>(length);
+        return synth_linear * x + synth_quad * x * x;
+    }
+};
+
+double cost_synth(int length, double cost_per_base);
+double cost_synth_nonlinear(int length, double linear_per_base, double quad_coeff);
+
+// Reads a synthesis price list: one "length cost" pair per line (whitespace
+// or comma separated, '#' comments), lengths increasing.  A row prices every
+// length above the previous row up to its own, so vendor brackets ("up to
+// 500 bp: 89.00") are one line each.  table[L] is the price of L bases, for
+// L up to the last row.  Prints an error and returns false on bad input.
+bool load_synth_table(const std::string& path, std::vector<double>& table);
+
+// --- REUSE PROFILE ---
+
+// For a target record of length N (positions are 0-based, intervals half-open):
+//   end_len[i]   = longest w <= W such that seq[i-w, i) occurs in a source index
+//   start_len[i] = longest w <= W such that seq[i, i+w) occurs in a source index
+//   multi_len[i] = longest w <= end_len[i] such that seq[i-w, i) occurs more
+//                  than once over all source indexes (empty unless requested)
+// With self-reuse a copy that ends before the block starts, earlier in the
+// record, counts as an occurrence as well.
+//   approx_len[d-1][i] = longest w <= W such that seq[i-w, i) is within d
+//                  substitutions of a string of a source index, d = 1..k
+//                  (empty unless mismatches are allowed); at least end_len[i]
+//                  from the sources alone
+// Reusability and repetition are substring-closed, so every shorter block
+// sharing the same end (resp. start) is reusable, resp. repeated, as well.
+// The arrays have N+1 entries.
+struct ReuseProfile {
+    int W = 0;
+    std::vector<std::uint16_t> end_len;
+    std::vector<std::uint16_t> start_len;
+    std::vector<std::uint16_t> multi_len;
+    std::vector<std::vector<std::uint16_t>> approx_len;
+    // With per-source prices: the distinct prices ascending, and
+    // tier_len[t][i] the longest suffix of seq[0, i) in an index priced at
+    // most tier_pcr[t] (non-decreasing in t, at most end_len[i]).
+    std::vector<double> tier_pcr;
+    std::vector<std::vector<std::uint16_t>> tier_len;
+
+    // Whether seq[i-w, i), with w <= end_len[i], occurs more than once.
+    bool repeated(size_t i, int w) const { return !multi_len.empty() && w <= multi_len[i]; }
+    // Fewest substitutions that make seq[i-w, i) a source string, or -1 if
+    // more than approx_len.size() are needed.
+    int mismatches(size_t i, int w) const {
+        if (w <= end_len[i]) return 0;
+        for (size_t d = 0; d < approx_len.size(); ++d) {
+            if (w <= approx_len[d][i]) return static_cast<int>(d) + 1;
+        }
+        return -1;
+    }
+    // Cheapest price tier holding seq[i-w, i), or -1 if none does (no
+    // per-source prices, or only a self-reuse copy).
+    int tier(size_t i, int w) const {
+        for (size_t t = 0; t < tier_len.size(); ++t) {
+            if (w <= tier_len[t][i]) return static_cast<int>(t);
+        }
+        return -1;
+    }
+};
+
+// Uses incremental backward_search ending at every position, so the whole
+// profile costs O(sum of end_len) rank operations.  Lengths below min_len
+// are recorded as 0, and positions whose last min_len bases are known not to
+// occur are skipped without searching.  Searches stop at max_len (0 = W).
+// With occurrences, multi_len is filled from the width of the same suffix
+// array intervals, at no extra rank cost.  With self, copies earlier in seq
+// count as sources too (add_self_reuse), before start_len is derived.
+// With mismatches = k > 0, approx_len is filled by a bounded backtracking
+// search per index (substitutions only), pruned by approx_len[d][i] <=
+// approx_len[d][i-1] + 1.  Several indexes are searched in parallel, each
+// on its own, and merged; with source_pcr (one price per donor) the merge
+// also fills tier_pcr / tier_len.  colors, if given, holds the donor colours
+// of each index (null for a plain one): a panel index then ranks its donors
+// by the cheapest tier of each suffix array interval (DonorTiers).
+ReuseProfile compute_reuse_profile(const std::string& seq, int W, const std::vector<text_index_t>& indexes,
+                                   int min_len = 1, int max_len = 0, bool occurrences = false, bool self = false,
+                                   int mismatches = 0, const std::vector<double>& source_pcr = {},
+                                   const std::vector<const DonorColors*>& colors = {});
+
+// Reuse ends of each donor on its own: ends[d][r] is the end_len of seqs[r]
+// against donor d (SourceIndex::donors order) alone, without self-reuse.  A
+// donor of a panel index is searched over the generalized index with a
+// ranking of its own (DonorTiers: the donor at tier 0, every other at 1),
+// built once for all records and not cached.  Donors run in parallel.
+std::vector<std::vector<std::vector<std::uint16_t>>> donor_reuse_ends(const std::vector<std::string>& seqs, int W,
+                                                                      const SourceIndex& source, int min_len = 1,
+                                                                      int max_len = 0);
+
+// --- CIRCULAR RECORDS ---
+
+// A circular record of N bases is planned on its extension
+//   seq[N - m, N) + seq + seq[0, m)    (indices mod N, so any N >= 1)
+// with m = circular_margin(costs, W): every block, fragment, primer site and
+// motif across the origin is an ordinary substring of it, so the profile of
+// the extension answers wrapped blocks and the planners index it directly.
+long long circular_margin(const CostModel& costs, int W);
+std::string circular_extension(const std::string& seq, long long margin);
+
+// The profile the planners expect for seq under costs: that of seq, or of its
+// circular extension with costs.circular.
+ReuseProfile compute_plan_profile(const std::string& seq, int W, const SourceIndex& source, const CostModel& costs);
+
+// --- PLANNERS ---
+
+// One block of a plan, covering seq[start, start + length).  On a circular
+// record the last block may run past N, i.e. wrap to seq[0, start + length - N).
+struct PlanBlock {
+    std::uint64_t start = 0;
+    std::uint32_t length = 0;
+    bool reuse = false;
+    double cost = 0.0;        // acquisition plus the block join before it
+    std::uint8_t level = 0;   // with CostModel::levels: highest level joined at start
+    std::uint8_t mismatches = 0;   // reused blocks: substitutions to correct by mutagenesis
+};
+
+// When blocks is non-null the chosen blocks are written to it in target order;
+// on a circular record only the last one may wrap.
+// With CostModel::levels every planner's blocks are assembled through the
+// levels and the stats cost is the hierarchical one.
+class Planner {
+public:
+    virtual ~Planner() = default;
+    virtual const char* name() const = 0;
+    virtual PlannerStats plan(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                              std::vector<PlanBlock>* blocks = nullptr) const = 0;
+};
+
+// Names: "dp", "greedy" (replication-first), "maxblock".  Returns nullptr on unknown names.
+std::unique_ptr<Planner> make_planner(const std::string& name);
+std::vector<std::string> planner_names();
+
+PlannerStats solve_dp_for_chromosome(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                     std::vector<PlanBlock>* blocks = nullptr);
+PlannerStats solve_greedy_for_chromosome_stats(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                               std::vector<PlanBlock>* blocks = nullptr);
+PlannerStats solve_max_block_greedy_for_chromosome_stats(const std::string& chrom_seq, const ReuseProfile& reuse, const CostModel& costs,
+                                                         std::vector<PlanBlock>* blocks = nullptr);
+
+// --- INCREMENTAL DP ---
+
+// DP cost of one linear record under many reuse profiles that differ in few
+// places, e.g. the donor subsets of a panel.  DP[i] reads the profile only
+// at i, so a candidate is re-solved from its first position that differs
+// from the reference profile; once its DP has run parallel to the
+// reference over W positions it is the reference plus a constant up to the
+// next difference, where it resumes.  The caller names the differences and
+// the candidate's DP is kept in a window of a few W positions, so a donor
+// adding reuse in a few places costs a few windows of W instead of a pass
+// over the record.  Costs are those of solve_dp_for_chromosome, without
+// levels (and with synth_reusable if set); every profile must be of the same
+// record, with the same W and tier_pcr.  The session keeps the reference DP,
+// not the reference profile.
+class DpSession {
+public:
+    DpSession(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs);
+    ~DpSession();
+    DpSession(DpSession&&) noexcept;
+    DpSession& operator=(DpSession&&) noexcept;
+
+    // Optimal cost under the reference profile.
+    double cost() const;
+    // Optimal cost under candidate, which may differ from the reference
+    // profile only at the ascending positions in changed (a superset is
+    // fine); safe to call from several threads.
+    double evaluate(const ReuseProfile& candidate, const std::vector<long long>& changed) const;
+    // Makes candidate the reference profile (a pass over the record).
+    void adopt(const ReuseProfile& candidate);
+
+    struct Impl;   // state in the record's cost type (planner_core.cpp)
+
+private:
+    std::unique_ptr<Impl> impl_;
+};
+
+// --- COMMAND LINE ---
+
+// Arguments shared by the planner binaries:
+//   [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <source_index.fm>
+// Options:
+//   --regions R   plan only these loci (BED file or chr:start-end list, see
+//                 parse_regions); needs an uncompressed target with a .fai
+//   --split-gaps  keep N runs and IUPAC codes as hard boundaries and plan each
+//                 gap-free segment separately, in original coordinates
+//   --cost-scale S  run the DP in integer units of 1/S (CostModel::scale)
+//   --synth-table F per-length synthesis prices (load_synth_table)
+//   --reuse-min L, --reuse-max L, --pcr-per-base X
+//                 reuse length limits and length-dependent PCR cost
+//   --multi-penalty X, --unique-only
+//                 extra cost for, or no reuse of, blocks occurring more than
+//                 once in the sources
+//   --primer-len P, --primer-gc LO,HI, --primer-tm LO,HI, --primer-penalty X
+//                 primer-site penalties of reused blocks (PrimerRules)
+//   --synth-penalty X, --synth-gc LO,HI, --synth-homopolymer H, --synth-repeat R
+//                 complexity penalties of synthesised blocks (SynthRules)
+//   --forbid-motifs F, --forbid-motif SEQ[,SEQ...]
+//                 no junction inside these motifs (CostModel::forbidden_motifs)
+//   --overlap L   blocks after the first are acquired L bases early (CostModel::overlap)
+//   --levels LEN:JOIN[,LEN:JOIN...]
+//                 hierarchical assembly levels (CostModel::levels)
+//   --circular    records are circular, blocks may wrap (CostModel::circular)
+//   --self-reuse  earlier copies in the record are sources too (CostModel::self_reuse)
+//   --mismatches K, --mismatch-cost X
+//                 mutagenic PCR of near-copies (CostModel::max_mismatches)
+//   --source-pcr P[,P...]
+//                 PCR price of each index in a comma-separated index list
+//                 (CostModel::source_pcr)
+struct PlannerArgs {
+    int W = 0;
+    std::string fasta_path;
+    CostModel costs;
+    std::string index_path;
+    std::string regions;
+    bool split_gaps = false;
+};
+
+// Parses argv[first .. argc).  Prints an error and returns false on bad input.
+bool parse_planner_args(int argc, char* argv[], int first, PlannerArgs& out);
+// Parses a comma-separated list of prices, e.g. --source-pcr.
+bool parse_price_list(const std::string& text, std::vector<double>& prices);
+// Help text for the options accepted by parse_planner_args.
+const char* planner_options_help();
+
+// Plans every record of args.fasta_path with each planner, loading the index and
+// computing each record's reuse profile once.  Records are streamed in file
+// order and the next one is read while the current one is planned.  With
+// args.regions only those intervals are read (through the .fai) and they are
+// planned in parallel; rows still follow the region order.  With
+// args.split_gaps every record or region is cut at its N runs and the
+// segments are planned in parallel, one row each, labelled
+// <chrom>:<start>-<end> in 1-based record coordinates.
+// Writes the CSV rows to stdout.
+// With a single planner the output keeps the historical 4-column schema;
+// otherwise each row is prefixed with the planner name.
+int run_planners(const PlannerArgs& args, const std::vector<const Planner*>& planners);
@@ -0,0 +1,609 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <cstdlib>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "planner_core.hpp"
+
+// Resident planning daemon: keeps source indexes loaded and serves
+// newline-delimited JSON planning requests from a worker pool.
+
+// --- MINIMAL JSON ---
+
+// Requests are flat JSON objects; each value is kept as its raw text plus the
+// decoded string/number so that "id" can be echoed back verbatim.
+struct JsonField {
+    std::string raw;
+    std::string str;
+    double num = 0.0;
+    bool is_string = false;
+    bool is_number = false;
+};
+
+static void skip_ws(const std::string& s, size_t& p) {
+    while (p < s.size() && (s[p] == ' ' || s[p] == '\t' || s[p] == '\r' || s[p] == '\n')) ++p;
+}
+
+static bool parse_json_string(const std::string& s, size_t& p, std::string& out) {
+    if (p >= s.size() || s[p] != '"') return false;
+    ++p;
+    out.clear();
+    while (p < s.size() && s[p] != '"') {
+        char c = s[p++];
+        if (c == '\\') {
+            if (p >= s.size()) return false;
+            char e = s[p++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                    // Sequences and planner names are ASCII; keep non-ASCII escapes as '?'.
+                    if (p + 4 > s.size()) return false;
+                    {
+                        const unsigned long code = std::strtoul(s.substr(p, 4).c_str(), nullptr, 16);
+                        out += (code < 0x80) ? static_cast<char>(code) : '?';
+                    }
+                    p += 4;
+                    break;
+                default: out += e; break;
+            }
+        } else {
+            out += c;
+        }
+    }
+    if (p >= s.size()) return false;
+    ++p;
+    return true;
+}
+
+static bool parse_json_object(const std::string& s, std::map<std::string, JsonField>& fields, std::string& err) {
+    size_t p = 0;
+    skip_ws(s, p);
+    if (p >= s.size() || s[p] != '{') { err = "request is not a JSON object"; return false; }
+    ++p;
+    skip_ws(s, p);
+    if (p < s.size() && s[p] == '}') return true;
+    while (p < s.size()) {
+        skip_ws(s, p);
+        std::string key;
+        if (!parse_json_string(s, p, key)) { err = "expected string key"; return false; }
+        skip_ws(s, p);
+        if (p >= s.size() || s[p] != ':') { err = "expected ':' after key"; return false; }
+        ++p;
+        skip_ws(s, p);
+        JsonField f;
+        const size_t begin = p;
+        if (p < s.size() && s[p] == '"') {
+            if (!parse_json_string(s, p, f.str)) { err = "unterminated string"; return false; }
+            f.is_string = true;
+        } else {
+            while (p < s.size() && s[p] != ',' && s[p] != '}' && s[p] != ' ' && s[p] != '\t') ++p;
+            const std::string tok = s.substr(begin, p - begin);
+            if (tok == "true" || tok == "false" || tok == "null") {
+                f.num = (tok == "true") ? 1.0 : 0.0;
+                f.is_number = true;
+            } else {
+                char* end = nullptr;
+                f.num = std::strtod(tok.c_str(), &end);
+                if (tok.empty() || end != tok.c_str() + tok.size()) { err = "unsupported value for '" + key + "'"; return false; }
+                f.is_number = true;
+            }
+        }
+        f.raw = s.substr(begin, p - begin);
+        fields[key] = std::move(f);
+        skip_ws(s, p);
+        if (p < s.size() && s[p] == ',') { ++p; continue; }
+        if (p < s.size() && s[p] == '}') return true;
+        err = "expected ',' or '}'";
+        return false;
+    }
+    err = "unterminated object";
+    return false;
+}
+
+static std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 2);
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+                else out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// --- WORKER POOL ---
+
+// Requests are the unit of parallelism: each worker plans one at a time on
+// its own thread, so the OpenMP regions inside the planner (profiles,
+// segments) run single-threaded there instead of every worker starting a
+// team of hardware-concurrency threads.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads) {
+        for (int t = 0; t < threads; ++t) {
+            workers_.emplace_back([this] {
+#ifdef _OPENMP
+                omp_set_num_threads(1);
+#endif
+                run();
+            });
+        }
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                // Drain the queue before exiting so no accepted request is dropped.
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+// --- REQUEST HANDLING ---
+
+struct ServerState {
+    std::map<std::string, SourceIndex> sources;
+    std::string default_source;
+};
+
+static std::string error_reply(const std::string& id_raw, const std::string& msg) {
+    std::string out = "{";
+    if (!id_raw.empty()) out += "\"id\":" + id_raw + ",";
+    out += "\"error\":" + json_escape(msg) + "}";
+    return out;
+}
+
+// Request fields:
+//   id            any JSON scalar, echoed back
+//   seq           target sequence (cleaned like FASTA input: non-ACGT dropped)
+//   W, pcr, join, synth_linear, synth_quad   as on the command line
+//   cost_scale    integer DP units of 1/cost_scale, as --cost-scale (default off)
+//   reuse_min, reuse_max, pcr_per_base   as --reuse-min/--reuse-max/--pcr-per-base
+//   multi_penalty, unique_only           as --multi-penalty/--unique-only
+//   primer_len, primer_gc_min, primer_gc_max, primer_tm_min, primer_tm_max,
+//   primer_penalty                       as --primer-len/--primer-gc/--primer-tm/--primer-penalty
+//   synth_penalty, synth_gc_min, synth_gc_max, synth_homopolymer,
+//   synth_repeat                         as --synth-penalty/--synth-gc/--synth-homopolymer/--synth-repeat
+//   forbid_motif  comma-separated motifs, as --forbid-motif
+//   overlap       Gibson overlap in bp, as --overlap (default 0)
+//   levels        "LEN:JOIN[,LEN:JOIN...]", as --levels; blocks then carry
+//                 the level joined at their start as a fourth element
+//   circular      true to plan seq as a circle, as --circular; the last
+//                 block may then run past the end (default false)
+//   self_reuse    true to reuse earlier copies within seq, as --self-reuse
+//                 (default false)
+//   mismatches, mismatch_cost            as --mismatches/--mismatch-cost; results
+//                 then report their substitutions and every block carries its
+//                 own as a last element
+//   planner       comma-separated subset of dp,greedy,maxblock or "all" (default dp)
+//   index         name of a resident index (default: the first one given)
+//   source_pcr    comma-separated PCR price per donor of the resident index
+//                 (each index of a list, each donor of a panel index), as
+//                 --source-pcr (default: pcr for every donor)
+//   blocks        false to omit the block list from the reply (default true)
+//   split_gaps    true to keep N/IUPAC positions and plan each gap-free
+//                 segment on its own; blocks then use coordinates of seq
+//                 with only whitespace removed (default false)
+static std::string handle_request(const ServerState& state, const std::string& line) {
+    std::map<std::string, JsonField> req;
+    std::string err;
+    if (!parse_json_object(line, req, err)) return error_reply("", err);
+
+    const std::string id_raw = req.count("id") ? req["id"].raw : std::string();
+    auto number = [&](const char* key, double def) {
+        auto it = req.find(key);
+        return (it != req.end() && it->second.is_number) ? it->second.num : def;
+    };
+    auto string = [&](const char* key, const std::string& def) {
+        auto it = req.find(key);
+        return (it != req.end() && it->second.is_string) ? it->second.str : def;
+    };
+
+    if (!req.count("seq") || !req["seq"].is_string) return error_reply(id_raw, "missing 'seq'");
+    const double W_arg = number("W", 0.0);
+    if (W_arg < 1 || W_arg > kMaxBlockLen) {
+        return error_reply(id_raw, "W must be in [1, " + std::to_string(kMaxBlockLen) + "]");
+    }
+    const int W = static_cast<int>(W_arg);
+
+    CostModel costs;
+    costs.pcr = number("pcr", 0.0);
+    costs.join = number("join", 0.0);
+    costs.synth_linear = number("synth_linear", 0.0);
+    costs.synth_quad = number("synth_quad", 0.0);
+    costs.scale = number("cost_scale", 0.0);
+    if (costs.scale < 0.0) return error_reply(id_raw, "cost_scale must be positive");
+    costs.reuse_min = std::max(1, static_cast<int>(number("reuse_min", 1.0)));
+    costs.reuse_max = static_cast<int>(number("reuse_max", 0.0));
+    costs.pcr_per_base = number("pcr_per_base", 0.0);
+    costs.multi_penalty = number("multi_penalty", 0.0);
+    costs.unique_only = number("unique_only", 0.0) != 0.0;
+    costs.primer.length = static_cast<int>(number("primer_len", 0.0));
+    costs.primer.gc_min = number("primer_gc_min", costs.primer.gc_min);
+    costs.primer.gc_max = number("primer_gc_max", costs.primer.gc_max);
+    costs.primer.tm_min = number("primer_tm_min", costs.primer.tm_min);
+    costs.primer.tm_max = number("primer_tm_max", costs.primer.tm_max);
+    costs.primer.penalty = number("primer_penalty", costs.primer.penalty);
+    costs.synth_rules.penalty = number("synth_penalty", 0.0);
+    costs.synth_rules.gc_min = number("synth_gc_min", costs.synth_rules.gc_min);
+    costs.synth_rules.gc_max = number("synth_gc_max", costs.synth_rules.gc_max);
+    costs.synth_rules.max_homopolymer = static_cast<int>(number("synth_homopolymer", costs.synth_rules.max_homopolymer));
+    costs.synth_rules.max_repeat = static_cast<int>(number("synth_repeat", costs.synth_rules.max_repeat));
+    if (!parse_motif_list(string("forbid_motif", ""), costs.forbidden_motifs)) {
+        return error_reply(id_raw, "forbid_motif must be comma-separated A/C/G/T motifs");
+    }
+    costs.overlap = static_cast<int>(number("overlap", 0.0));
+    if (costs.overlap < 0 || costs.overlap >= W) return error_reply(id_raw, "overlap must be in [0, W)");
+    const std::string level_list = string("levels", "");
+    if (!level_list.empty() &&
+        (!parse_assembly_levels(level_list, costs.levels) || costs.levels.front().max_len < W)) {
+        return error_reply(id_raw, "levels must be LEN:JOIN[,LEN:JOIN...] with LEN increasing from at least W");
+    }
+    costs.circular = number("circular", 0.0) != 0.0;
+    costs.self_reuse = number("self_reuse", 0.0) != 0.0;
+    if (costs.circular && costs.self_reuse) return error_reply(id_raw, "self_reuse cannot be combined with circular");
+    costs.max_mismatches = static_cast<int>(number("mismatches", 0.0));
+    costs.mismatch_cost = number("mismatch_cost", 0.0);
+    if (costs.max_mismatches < 0 || costs.max_mismatches > kMaxMismatches) {
+        return error_reply(id_raw, "mismatches must be in [0, " + std::to_string(kMaxMismatches) + "]");
+    }
+    if (costs.synth_rules.penalty < 0.0) return error_reply(id_raw, "synth_penalty must be non-negative");
+    if (costs.synth_rules.max_homopolymer < 0) return error_reply(id_raw, "synth_homopolymer must be non-negative");
+    if (costs.synth_rules.max_repeat < costs.synth_rules.min_repeat_limit()) {
+        return error_reply(id_raw, "synth_repeat must be at least " + std::to_string(costs.synth_rules.min_repeat_limit()));
+    }
+    if (costs.primer.length < 0 || costs.primer.length > kMaxBlockLen) {
+        return error_reply(id_raw, "primer_len must be in [0, " + std::to_string(kMaxBlockLen) + "]");
+    }
+    if (costs.reuse_max < 0 || (costs.reuse_max > 0 && costs.reuse_max < costs.reuse_min)) {
+        return error_reply(id_raw, "reuse_max must be 0 or at least reuse_min");
+    }
+
+    const std::string source_name = string("index", state.default_source);
+    auto src = state.sources.find(source_name);
+    if (src == state.sources.end()) return error_reply(id_raw, "unknown index '" + source_name + "'");
+    const std::string price_list = string("source_pcr", "");
+    if (!price_list.empty() &&
+        (!parse_price_list(price_list, costs.source_pcr) || costs.source_pcr.size() != src->second.donors())) {
+        return error_reply(id_raw, "source_pcr must list one price per donor of '" + source_name + "' (" +
+                                   std::to_string(src->second.donors()) + ")");
+    }
+
+    std::vector<std::string> names;
+    const std::string planner_list = string("planner", "dp");
+    if (planner_list == "all") {
+        names = planner_names();
+    } else {
+        std::stringstream ss(planner_list);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            if (!name.empty()) names.push_back(name);
+        }
+    }
+    std::vector<std::unique_ptr<Planner>> planners;
+    for (const std::string& name : names) {
+        std::unique_ptr<Planner> planner = make_planner(name);
+        if (!planner) return error_reply(id_raw, "unknown planner '" + name + "'");
+        planners.push_back(std::move(planner));
+    }
+    if (planners.empty()) return error_reply(id_raw, "no planner selected");
+    const bool want_blocks = number("blocks", 1.0) != 0.0;
+
+    const bool split_gaps = number("split_gaps", 0.0) != 0.0;
+    if (split_gaps && costs.circular) return error_reply(id_raw, "circular cannot be combined with split_gaps");
+
+    std::string seq;
+    const std::string& raw_seq = req["seq"].str;
+    seq.reserve(raw_seq.size());
+    append_clean_bases(raw_seq.data(), raw_seq.size(), seq, split_gaps);
+    const std::vector<Segment> segments = split_gaps ? gap_free_segments(seq) : std::vector<Segment>{{0, seq.size()}};
+
+    // Plan each segment with every planner; stats add up across segments and
+    // block starts are shifted back to positions in seq.
+    std::vector<PlannerStats> stats(planners.size());
+    std::vector<std::vector<PlanBlock>> blocks(planners.size());
+    std::vector<PlanBlock> seg_blocks;
+    for (const Segment& segment : segments) {
+        if (segment.end == segment.start) continue;
+        const std::string part = split_gaps ? seq.substr(segment.start, segment.end - segment.start) : std::string();
+        const std::string& target = split_gaps ? part : seq;
+        const ReuseProfile reuse = compute_plan_profile(target, W, src->second, costs);
+        for (size_t p = 0; p < planners.size(); ++p) {
+            stats[p].accumulate(planners[p]->plan(target, reuse, costs, want_blocks ? &seg_blocks : nullptr));
+            for (PlanBlock block : seg_blocks) {
+                block.start += segment.start;
+                blocks[p].push_back(block);
+            }
+            seg_blocks.clear();
+        }
+    }
+
+    for (size_t p = 0; p < planners.size(); ++p) {
+        if (!stats[p].planned) {
+            return error_reply(id_raw, std::string("no ") + planners[p]->name() +
+                                           " plan: every block boundary of the circular sequence is inside a forbidden motif");
+        }
+    }
+
+    std::ostringstream out;
+    out << "{";
+    if (!id_raw.empty()) out << "\"id\":" << id_raw << ",";
+    out << "\"index\":" << json_escape(source_name) << ",\"length\":" << seq.size() << ",\"results\":[";
+    for (size_t p = 0; p < planners.size(); ++p) {
+        if (p > 0) out << ",";
+        out << "{\"planner\":\"" << planners[p]->name() << "\""
+            << ",\"cost\":" << stats[p].cost
+            << ",\"reuse_moves\":" << stats[p].reuse_moves
+            << ",\"synth_moves\":" << stats[p].synth_moves
+            << ",\"joins\":" << stats[p].joins
+            << ",\"segments\":" << stats[p].segments
+            << ",\"reuse_bases\":" << stats[p].reuse_bases
+            << ",\"synth_bases\":" << stats[p].synth_bases;
+        if (costs.max_mismatches > 0) out << ",\"mismatches\":" << stats[p].mismatches;
+        if (want_blocks) {
+            // Each block is [start, length, "R"|"S"] in target coordinates of the cleaned sequence.
+            out << ",\"blocks\":[";
+            for (size_t b = 0; b < blocks[p].size(); ++b) {
+                if (b > 0) out << ",";
+                const PlanBlock& block = blocks[p][b];
+                out << "[" << block.start << "," << block.length << ",\"" << (block.reuse ? 'R' : 'S') << "\"";
+                if (!costs.levels.empty()) out << "," << static_cast<int>(block.level);
+                if (costs.max_mismatches > 0) out << "," << static_cast<int>(block.mismatches);
+                out << "]";
+            }
+            out << "]";
+        }
+        out << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+// --- TRANSPORTS ---
+
+static bool write_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        const ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n <= 0) return false;
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Output side of one client.  Replies may complete out of order, so each is
+// written atomically as one line; clients match them by "id".
+struct Connection {
+    int fd;
+    std::mutex mu;
+    explicit Connection(int f) : fd(f) {}
+    ~Connection() { if (fd > 2) ::close(fd); }
+    void reply(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mu);
+        write_all(fd, line + "\n");
+    }
+};
+
+// Reads newline-delimited requests from in_fd and dispatches them to the pool.
+// Returns once in_fd reaches EOF; pending replies keep the connection alive.
+static void serve_stream(int in_fd, std::shared_ptr<Connection> conn, const ServerState& state, WorkerPool& pool) {
+    std::string buffer;
+    char chunk[1 << 16];
+    for (;;) {
+        const ssize_t n = ::read(in_fd, chunk, sizeof(chunk));
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+        size_t start = 0;
+        for (size_t nl; (nl = buffer.find('\n', start)) != std::string::npos; start = nl + 1) {
+            std::string line = buffer.substr(start, nl - start);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            pool.submit([conn, &state, line = std::move(line)] { conn->reply(handle_request(state, line)); });
+        }
+        buffer.erase(0, start);
+    }
+    if (buffer.find_first_not_of(" \t\r") != std::string::npos) {
+        pool.submit([conn, &state, line = std::move(buffer)] { conn->reply(handle_request(state, line)); });
+    }
+}
+
+static int serve_socket(const std::string& path, const ServerState& state, WorkerPool& pool) {
+    const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "ERROR: socket(): " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "ERROR: Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, 64) < 0) {
+        std::cerr << "ERROR: Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listen_fd);
+        return 1;
+    }
+    std::cerr << "Listening on " << path << std::endl;
+    for (;;) {
+        const int client = ::accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: accept(): " << std::strerror(errno) << std::endl;
+            break;
+        }
+        // One lightweight reader thread per client; planning runs on the pool.
+        std::thread([client, &state, &pool] {
+            auto conn = std::make_shared<Connection>(client);
+            serve_stream(client, conn, state, pool);
+            ::shutdown(client, SHUT_RD);
+        }).detach();
+    }
+    ::close(listen_fd);
+    ::unlink(path.c_str());
+    return 1;
+}
+
+// --- MAIN PROGRAM ---
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--help") {
+        std::cout << "Usage: " << argv[0] << " [--socket PATH] [--threads N] <name=index.fm> [name=index.fm ...]\n\n"
+                  << "Resident planning server.  Loads the given FM-indexes once and serves\n"
+                  << "planning requests as newline-delimited JSON, one reply line per request.\n\n"
+                  << "Options:\n"
+                  << "  --socket PATH    Listen on a Unix domain socket (default: read stdin, reply on stdout).\n"
+                  << "  --threads N      Worker threads planning requests concurrently\n"
+                  << "                   (default: hardware concurrency).  Each request is planned\n"
+                  << "                   on one thread, so N threads in total.\n"
+                  << "  name=index.fm    Resident index and the name requests refer to it by.\n"
+                  << "                   A bare path is named after its file name.  The first\n"
+                  << "                   index is the default.  name=a.fm,b.fm,... loads a donor\n"
+                  << "                   panel searched as one source.\n\n"
+                  << "Request fields:\n"
+                  << "  id               Any JSON scalar, echoed back in the reply.\n"
+                  << "  seq              Target sequence (non-ACGT characters are dropped).\n"
+                  << "  W, pcr, join, synth_linear, synth_quad\n"
+                  << "                   Same meaning as for genome_planner_flex.\n"
+                  << "  cost_scale       Plan the DP in integer units of 1/cost_scale (see --cost-scale).\n"
+                  << "  reuse_min, reuse_max, pcr_per_base\n"
+                  << "                   Reusable length range and per-base PCR cost (see\n"
+                  << "                   --reuse-min, --reuse-max, --pcr-per-base).\n"
+                  << "  multi_penalty, unique_only\n"
+                  << "                   Extra cost for, or no reuse of, blocks occurring more than\n"
+                  << "                   once in the index (see --multi-penalty, --unique-only).\n"
+                  << "  primer_len, primer_gc_min, primer_gc_max, primer_tm_min, primer_tm_max,\n"
+                  << "  primer_penalty   Primer-site scoring of reused blocks (see --primer-len).\n"
+                  << "  synth_penalty, synth_gc_min, synth_gc_max, synth_homopolymer, synth_repeat\n"
+                  << "                   Complexity scoring of synthesised blocks (see --synth-penalty).\n"
+                  << "  forbid_motif     Comma-separated motifs no junction may fall inside (see\n"
+                  << "                   --forbid-motif).\n"
+                  << "  overlap          Gibson overlap in bp (see --overlap, default 0).\n"
+                  << "  levels           Assembly levels \"LEN:JOIN,...\" (see --levels); each block\n"
+                  << "                   then has a fourth element, the level joined at its start.\n"
+                  << "  circular         true to plan seq as a circle (see --circular); the last block\n"
+                  << "                   may then run past the end and wrap (default false).\n"
+                  << "  self_reuse       true to also amplify blocks from earlier copies within seq\n"
+                  << "                   (see --self-reuse, default false).\n"
+                  << "  mismatches, mismatch_cost\n"
+                  << "                   Mutagenic PCR of blocks within that many substitutions of\n"
+                  << "                   the source (see --mismatches); results then report\n"
+                  << "                   \"mismatches\" and each block ends with its own count.\n"
+                  << "  planner          dp, greedy, maxblock, a comma-separated list, or all (default dp).\n"
+                  << "  index            Resident index name (default: first index).\n"
+                  << "  source_pcr       Comma-separated PCR price per donor: per index of a list\n"
+                  << "                   name=a.fm,b.fm,... and per donor of a panel index (see\n"
+                  << "                   --source-pcr; default pcr for all).\n"
+                  << "  blocks           false to omit the block list (default true).\n"
+                  << "  split_gaps       true to keep N and IUPAC codes as gaps and plan each gap-free\n"
+                  << "                   segment separately; block starts and length then count\n"
+                  << "                   every non-whitespace character of seq (default false).\n\n"
+                  << "Reply: {\"id\":..,\"index\":..,\"length\":N,\"results\":[{\"planner\":..,\"cost\":..,\n"
+                  << "        <STATS_TOTAL fields>, \"blocks\":[[start,length,\"R\"|\"S\"],...]}]}\n"
+                  << "or {\"id\":..,\"error\":\"...\"}.  Replies may arrive out of request order.\n\n"
+                  << "Example:\n"
+                  << "  echo '{\"id\":1,\"seq\":\"ACGT...\",\"W\":500,\"pcr\":5,\"join\":1.5,\"synth_linear\":0.2}' \\\n"
+                  << "    | ./planner_server ecoli=ecoli_source.fm\n"
+                  << std::endl;
+        return 0;
+    }
+
+    std::string socket_path;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+    ServerState state;
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        if (arg == "--socket" && a + 1 < argc) {
+            socket_path = argv[++a];
+        } else if (arg == "--threads" && a + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++a]));
+        } else {
+            const size_t eq = arg.find('=');
+            const std::string path = (eq == std::string::npos) ? arg : arg.substr(eq + 1);
+            const std::string name = (eq == std::string::npos) ? std::filesystem::path(path).stem().string() : arg.substr(0, eq);
+            SourceIndex source;
+            if (!load_source_index(path, source)) { return 1; }
+            const size_t donors = source.donors();
+            if (state.sources.empty()) state.default_source = name;
+            state.sources[name] = std::move(source);
+            std::cerr << "Loaded index '" << name << "' from " << path;
+            if (donors > 1) std::cerr << " (" << donors << " donors)";
+            std::cerr << std::endl;
+        }
+    }
+    if (state.sources.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--threads N] <name=index.fm> [name=index.fm ...]"
+                  << "  (use --help for details)" << std::endl;
+        return 1;
+    }
+
+    // A client hanging up must not take the server down.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    WorkerPool pool(threads);
+    if (!socket_path.empty()) return serve_socket(socket_path, state, pool);
+
+    auto out = std::make_shared<Connection>(STDOUT_FILENO);
+    serve_stream(STDIN_FILENO, out, state, pool);
+    return 0;
+}
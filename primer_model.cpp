@@ -0,0 +1,106 @@
+#include "primer_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// --- NEAREST-NEIGHBOUR PARAMETERS ---
+
+namespace {
+
+// SantaLucia (1998) unified parameters, indexed by (5' base, 3' base) of the
+// top strand; enthalpy in kcal/mol, entropy in cal/(K mol).
+struct Stack {
+    double dh;
+    double ds;
+};
+
+int base_code(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+//                                 A               C               G               T   (3' base)
+constexpr Stack kStack[4][4] = {{{-7.9, -22.2}, {-8.4, -22.4}, {-7.8, -21.0}, {-7.2, -20.4}},    // A
+                                {{-8.5, -22.7}, {-8.0, -19.9}, {-10.6, -27.2}, {-7.8, -21.0}},   // C
+                                {{-8.2, -22.2}, {-9.8, -24.4}, {-8.0, -19.9}, {-8.4, -22.4}},    // G
+                                {{-7.2, -21.3}, {-8.2, -22.2}, {-8.5, -22.7}, {-7.9, -22.2}}};   // T
+
+// Initiation with a terminal G.C or A.T pair, charged at each end.
+constexpr Stack kInitGC = {0.1, -2.8};
+constexpr Stack kInitAT = {2.3, 4.1};
+
+constexpr double kGasConstant = 1.987;       // cal/(K mol)
+constexpr double kPrimerConc = 250e-9;       // M, non-self-complementary: C/4
+constexpr double kSodium = 0.05;             // M
+
+Stack initiation(char c) {
+    return (c == 'G' || c == 'C') ? kInitGC : kInitAT;
+}
+
+double outside(double x, double lo, double hi) {
+    return std::max({0.0, lo - x, x - hi});
+}
+
+} // namespace
+
+// --- WINDOW TABLES ---
+
+PrimerTables::PrimerTables(const std::string& seq) : seq_(seq) {
+    const size_t N = seq.size();
+    gc_.assign(N + 1, 0);
+    dh_.assign(N + 1, 0.0);
+    ds_.assign(N + 1, 0.0);
+    for (size_t k = 0; k < N; ++k) {
+        gc_[k + 1] = gc_[k] + ((seq[k] == 'G' || seq[k] == 'C') ? 1 : 0);
+    }
+    for (size_t k = 1; k < N; ++k) {
+        const int x = base_code(seq[k - 1]);
+        const int y = base_code(seq[k]);
+        const Stack s = (x >= 0 && y >= 0) ? kStack[x][y] : Stack{0.0, 0.0};
+        dh_[k + 1] = dh_[k] + s.dh;
+        ds_[k + 1] = ds_[k] + s.ds;
+    }
+}
+
+double PrimerTables::gc_percent(size_t a, size_t b) const {
+    if (b <= a) return 0.0;
+    return 100.0 * static_cast<double>(gc_[b] - gc_[a]) / static_cast<double>(b - a);
+}
+
+double PrimerTables::tm(size_t a, size_t b) const {
+    if (b < a + 2) return -273.15;
+    const Stack head = initiation(seq_[a]);
+    const Stack tail = initiation(seq_[b - 1]);
+    const double dh = dh_[b] - dh_[a + 1] + head.dh + tail.dh;
+    const double steps = static_cast<double>(b - a - 1);
+    const double ds = ds_[b] - ds_[a + 1] + head.ds + tail.ds + 0.368 * steps * std::log(kSodium);
+    return 1000.0 * dh / (ds + kGasConstant * std::log(kPrimerConc / 4.0)) - 273.15;
+}
+
+// --- PENALTIES ---
+
+double primer_site_penalty(const PrimerTables& tables, size_t a, size_t b, const PrimerRules& rules) {
+    const double off = outside(tables.gc_percent(a, b), rules.gc_min, rules.gc_max) +
+                       outside(tables.tm(a, b), rules.tm_min, rules.tm_max);
+    return rules.penalty * off;
+}
+
+PrimerPenalties primer_penalties(const std::string& seq, const PrimerRules& rules) {
+    PrimerPenalties out;
+    if (!rules.enabled()) return out;
+    const size_t N = seq.size();
+    const size_t P = static_cast<size_t>(rules.length);
+    const PrimerTables tables(seq);
+    out.start.assign(N + 1, 0.0);
+    out.end.assign(N + 1, 0.0);
+    for (size_t k = 0; k <= N; ++k) {
+        out.start[k] = primer_site_penalty(tables, k, std::min(N, k + P), rules);
+        out.end[k] = primer_site_penalty(tables, (k > P) ? k - P : 0, k, rules);
+    }
+    return out;
+}
@@ -0,0 +1,57 @@
+#pragma once
+// Primer-site feasibility of reused blocks.
+//
+// A reused block [j, i) is amplified with a forward primer on seq[j, j+P)
+// and a reverse primer on the complement of seq[i-P, i).  Both sites are
+// scored from prefix sums over the target (GC count, nearest-neighbour
+// enthalpy and entropy), so any window costs O(1) and the penalty of a block
+// is start[j] + end[i].  Windows are clipped to the sequence; for blocks
+// shorter than P they reach past the block (use --reuse-min P).
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct PrimerRules {
+    int length = 0;          // P; 0 disables primer scoring
+    double gc_min = 40.0;    // acceptable GC content, percent
+    double gc_max = 60.0;
+    double tm_min = 52.0;    // acceptable melting temperature, degrees C
+    double tm_max = 62.0;
+    double penalty = 1.0;    // cost per percentage point / degree outside the ranges
+
+    bool enabled() const { return length > 0; }
+};
+
+// Per-position penalties, N+1 entries each:
+//   start[j] = penalty of the forward primer site seq[j, j+P)
+//   end[i]   = penalty of the reverse primer site seq[i-P, i)
+struct PrimerPenalties {
+    std::vector<double> start;
+    std::vector<double> end;
+
+    bool empty() const { return start.empty(); }
+    double block(size_t j, size_t i) const { return start[j] + end[i]; }
+};
+
+// Prefix sums over one sequence; window queries are O(1).
+class PrimerTables {
+public:
+    // Keeps a reference to seq, which must outlive the tables.
+    explicit PrimerTables(const std::string& seq);
+
+    // GC content of seq[a, b) in percent.
+    double gc_percent(size_t a, size_t b) const;
+    // Duplex melting temperature of seq[a, b) in degrees C (SantaLucia 1998
+    // unified nearest-neighbour parameters, 50 mM Na+, 250 nM primer).
+    double tm(size_t a, size_t b) const;
+
+private:
+    const std::string& seq_;
+    std::vector<int> gc_;        // gc_[k]: G/C among seq[0, k)
+    std::vector<double> dh_;     // dh_[k]: stacking enthalpy of steps (t, t+1), t + 1 < k
+    std::vector<double> ds_;     // entropy, likewise
+};
+
+double primer_site_penalty(const PrimerTables& tables, size_t a, size_t b, const PrimerRules& rules);
+PrimerPenalties primer_penalties(const std::string& seq, const PrimerRules& rules);
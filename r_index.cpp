@@ -0,0 +1,154 @@
+#include "r_index.hpp"
+
+#include <fstream>
+
+#include <sdsl/construct.hpp>
+
+namespace {
+
+const char* const kRIndexMagic = "r-index 1";
+
+} // namespace
+
+RIndex& RIndex::operator=(RIndex&& other) noexcept {
+    if (this != &other) {
+        n_ = other.n_;
+        runs_ = other.runs_;
+        C_ = other.C_;
+        run_starts_ = std::move(other.run_starts_);
+        heads_ = std::move(other.heads_);
+        char_runs_ = std::move(other.char_runs_);
+        char_select_ = std::move(other.char_select_);
+        char_run_count_ = other.char_run_count_;
+        bind();
+    }
+    return *this;
+}
+
+void RIndex::bind() {
+    run_rank_.set_vector(&run_starts_);
+    run_select_.set_vector(&run_starts_);
+    char_select_.resize(char_runs_.size());
+    for (size_t c = 0; c < char_runs_.size(); ++c) char_select_[c].set_vector(&char_runs_[c]);
+}
+
+// --- CONSTRUCTION ---
+
+void RIndex::build(sdsl::int_vector_buffer<8>& bwt) {
+    n_ = bwt.size();
+    // First pass: runs and character counts.
+    std::array<size_type, 256> occ{};
+    runs_ = 0;
+    char_run_count_.fill(0);
+    for (size_type i = 0; i < n_; ++i) {
+        const std::uint8_t c = static_cast<std::uint8_t>(bwt[i]);
+        if (i == 0 || c != static_cast<std::uint8_t>(bwt[i - 1])) {
+            ++runs_;
+            ++char_run_count_[c];
+        }
+        ++occ[c];
+    }
+    C_[0] = 0;
+    for (size_t c = 0; c < 256; ++c) C_[c + 1] = C_[c] + occ[c];
+
+    // Second pass: run starts, heads, and the count of c before each c-run.
+    sdsl::bit_vector starts(n_, 0);
+    sdsl::int_vector<8> heads(runs_);
+    std::vector<sdsl::bit_vector> char_starts(256);
+    for (size_t c = 0; c < 256; ++c) {
+        if (occ[c] > 0) char_starts[c] = sdsl::bit_vector(occ[c], 0);
+    }
+    std::array<size_type, 256> seen{};
+    size_type j = 0;
+    for (size_type i = 0; i < n_; ++i) {
+        const std::uint8_t c = static_cast<std::uint8_t>(bwt[i]);
+        if (i == 0 || c != static_cast<std::uint8_t>(bwt[i - 1])) {
+            starts[i] = 1;
+            heads[j++] = c;
+            char_starts[c][seen[c]] = 1;
+        }
+        ++seen[c];
+    }
+    run_starts_ = sdsl::sd_vector<>(starts);
+    char_runs_.assign(256, sdsl::sd_vector<>());
+    for (size_t c = 0; c < 256; ++c) {
+        if (occ[c] > 0) char_runs_[c] = sdsl::sd_vector<>(char_starts[c]);
+    }
+    sdsl::construct_im(heads_, heads, 0);
+    bind();
+}
+
+// --- QUERIES ---
+
+RIndex::size_type RIndex::rank(size_type i, char_type c) const {
+    if (i == 0 || C_[c + 1] == C_[c]) return 0;
+    // The run holding position i - 1.
+    const size_type j = run_rank_(i) - 1;
+    const size_type start = run_select_(j + 1);
+    const auto head = heads_.inverse_select(j);   // (c-runs before j, heads[j])
+    if (head.second == c) return char_select_[c](head.first + 1) + (i - start);
+    const size_type k = heads_.rank(j, c);
+    return k < char_run_count_[c] ? char_select_[c](k + 1) : C_[c + 1] - C_[c];
+}
+
+RIndex::size_type RIndex::backward_search(size_type l, size_type r, char_type c, size_type& l2, size_type& r2) const {
+    const size_type lo = C_[c] + rank(l, c);
+    const size_type hi = C_[c] + rank(r + 1, c);
+    l2 = lo;
+    r2 = hi - 1;
+    return hi - lo;
+}
+
+RIndex::size_type RIndex::count(const std::string& pattern) const {
+    size_type l = 0;
+    size_type r = n_ - 1;
+    for (auto it = pattern.rbegin(); it != pattern.rend(); ++it) {
+        size_type l2 = 0, r2 = 0;
+        if (backward_search(l, r, static_cast<char_type>(*it), l2, r2) == 0) return 0;
+        l = l2;
+        r = r2;
+    }
+    return r - l + 1;
+}
+
+// --- FILES ---
+
+bool RIndex::store(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+    out << kRIndexMagic << "\n";
+    sdsl::write_member(n_, out);
+    sdsl::write_member(runs_, out);
+    for (const size_type count : C_) sdsl::write_member(count, out);
+    run_starts_.serialize(out);
+    heads_.serialize(out);
+    for (size_t c = 0; c < 256; ++c) {
+        sdsl::write_member(char_run_count_[c], out);
+        char_runs_[c].serialize(out);
+    }
+    return static_cast<bool>(out);
+}
+
+bool RIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    if (!in.is_open() || !std::getline(in, magic) || magic != kRIndexMagic) return false;
+    sdsl::read_member(n_, in);
+    sdsl::read_member(runs_, in);
+    for (size_type& count : C_) sdsl::read_member(count, in);
+    run_starts_.load(in);
+    heads_.load(in);
+    char_runs_.assign(256, sdsl::sd_vector<>());
+    for (size_t c = 0; c < 256; ++c) {
+        sdsl::read_member(char_run_count_[c], in);
+        char_runs_[c].load(in);
+    }
+    bind();
+    return static_cast<bool>(in);
+}
+
+bool RIndex::is_r_index(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    return in.is_open() && std::getline(in, magic) && magic == kRIndexMagic;
+}
@@ -0,0 +1,72 @@
+#pragma once
+// Run-length compressed BWT (the counting part of the r-index).
+//
+// A collection of closely related genomes has a BWT of few, long runs: r
+// grows with the differences between the copies, not with their total
+// length n.  The index keeps only the runs:
+//   run_starts  – where each run starts (sd_vector, n bits with r ones)
+//   heads       – the character of each run (Huffman wavelet tree, r symbols)
+//   char_runs_c – for each character c, how many c precede each of its runs
+//                 (sd_vector over the n_c occurrences of c)
+// so it takes about r (2 log(n / r) + 8) bits.  rank_c(i) finds the run of
+// position i - 1: in a c-run it is the count before that run plus the offset
+// into it, otherwise the count before the next c-run.  That is one backward
+// search step, with the same suffix array intervals as the csa_wt built over
+// the same text (create_index builds both from one BWT), so donor colours
+// apply unchanged.  Locating occurrences is not supported; the planners only
+// count.
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sdsl/int_vector_buffer.hpp>
+#include <sdsl/sd_vector.hpp>
+#include <sdsl/wt_huff.hpp>
+
+class RIndex {
+public:
+    using size_type = std::uint64_t;
+    using char_type = std::uint8_t;
+
+    RIndex() = default;
+    RIndex(const RIndex&) = delete;
+    RIndex& operator=(const RIndex&) = delete;
+    RIndex(RIndex&& other) noexcept { *this = std::move(other); }
+    RIndex& operator=(RIndex&& other) noexcept;
+
+    // Builds the index from a BWT (text and sentinel, as SDSL constructs it).
+    void build(sdsl::int_vector_buffer<8>& bwt);
+
+    // Length of the BWT, sentinel included (as csa_wt::size).
+    size_type size() const { return n_; }
+    size_type runs() const { return runs_; }
+    // Occurrences of c in bwt[0, i).
+    size_type rank(size_type i, char_type c) const;
+    // The suffix array interval [l2, r2] of c P from [l, r] of P; returns
+    // its width (0 if c P does not occur), like sdsl::backward_search.
+    size_type backward_search(size_type l, size_type r, char_type c, size_type& l2, size_type& r2) const;
+    // Occurrences of pattern in the text.
+    size_type count(const std::string& pattern) const;
+
+    // Files start with a magic line, so load() tells them from a csa_wt.
+    bool store(const std::string& path) const;
+    bool load(const std::string& path);
+    static bool is_r_index(const std::string& path);
+
+private:
+    // Points the rank / select supports at this object's vectors.
+    void bind();
+
+    size_type n_ = 0;
+    size_type runs_ = 0;
+    std::array<size_type, 257> C_{};   // C_[c] = characters smaller than c
+    sdsl::sd_vector<> run_starts_;
+    sdsl::sd_vector<>::rank_1_type run_rank_;
+    sdsl::sd_vector<>::select_1_type run_select_;
+    sdsl::wt_huff<> heads_;
+    std::vector<sdsl::sd_vector<>> char_runs_;   // by character, empty if absent
+    std::vector<sdsl::sd_vector<>::select_1_type> char_select_;
+    std::array<size_type, 256> char_run_count_{};
+};
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+#include "donor_selection.hpp"
+
+// --- MAIN PROGRAM ---
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--help") {
+        std::cout << "Usage: " << argv[0]
+                  << " [--exact] <k> [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <donor_panel>\n\n"
+                  << "Chooses which donors of a panel to stock: for every k up to the given one,\n"
+                  << "the k donors under which the target set (all records of target.fasta) is\n"
+                  << "cheapest to build with the optimal DP planner.  Every record is searched\n"
+                  << "once per donor; each subset is then priced by re-solving the DP only where\n"
+                  << "its donors change the reusable blocks.  A reusable block may still be\n"
+                  << "synthesised where that is cheaper (a stocked donor need not be used), so\n"
+                  << "a subset can cost less than genome_planner_flex with the same donors.\n\n"
+                  << "Arguments:\n"
+                  << "  --exact          After the greedy pass, run a branch-and-bound search per k\n"
+                  << "                   for the optimal subset (exponential in the worst case;\n"
+                  << "                   meant for panels of up to a few dozen donors).  Without it\n"
+                  << "                   donors are added greedily, the one lowering the cost most\n"
+                  << "                   at each step.\n"
+                  << "  k                Largest subset size, or 'all' for every donor.\n"
+                  << "  options, W ... synth_quad\n"
+                  << "                   Same as genome_planner_flex (see its --help), except\n"
+                  << "                   --multi-penalty, --unique-only, --mismatches, --circular\n"
+                  << "                   and --levels.\n"
+                  << "  donor_panel      A panel index (create_index a.fa,b.fa,...) or a\n"
+                  << "                   comma-separated list of indexes, one donor each.\n\n"
+                  << "Output (CSV, one row per k from 0): k, total_cost, donors\n"
+                  << "with the donor names separated by ';' (greedy: in the order added).\n\n"
+                  << "Example:\n"
+                  << "  ./select_donors 5 1000 targets.fasta 5 1.5 0.2 1e-4 panel.fm\n"
+                  << std::endl;
+        return 0;
+    }
+    int a = 1;
+    bool exact = false;
+    if (a < argc && std::string(argv[a]) == "--exact") {
+        exact = true;
+        ++a;
+    }
+    if (a >= argc) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--exact] <k> [options] <W> <target.fasta> <pcr> <join> <synth_linear> [synth_quad] <donor_panel>"
+                  << "  (use --help for details)" << std::endl;
+        return 1;
+    }
+    int max_k = -1;
+    if (std::string(argv[a]) != "all") {
+        try {
+            max_k = std::stoi(argv[a]);
+        } catch (const std::exception&) {
+            max_k = -1;
+        }
+        if (max_k < 0) {
+            std::cerr << "ERROR: k must be a non-negative integer or 'all'" << std::endl;
+            return 1;
+        }
+    }
+
+    PlannerArgs args;
+    if (!parse_planner_args(argc, argv, a + 1, args)) { return 1; }
+    return run_donor_selection(args, max_k, exact);
+}
@@ -0,0 +1,161 @@
+#include "self_reuse.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+// --- SUFFIX AUTOMATON ---
+
+namespace {
+
+int base_code(char c) {
+    switch (c) {
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return 0;
+    }
+}
+
+constexpr std::uint32_t kNoEnd = std::numeric_limits<std::uint32_t>::max();
+
+// Suffix automaton of one record, one 32-byte state per entry (the walk
+// touches a state and its suffix link only).  Transitions to state 0 mean
+// "none" (the root is never a target).  first / second are the smallest and
+// second smallest end positions (exclusive) of the state's strings.
+struct AutomatonState {
+    std::array<std::uint32_t, 4> next = {0, 0, 0, 0};
+    std::uint32_t link = 0;
+    std::uint32_t len = 0;
+    std::uint32_t first = kNoEnd;
+    std::uint32_t second = kNoEnd;
+};
+
+std::vector<AutomatonState> build_automaton(const std::string& seq) {
+    const size_t N = seq.size();
+    std::vector<AutomatonState> st;
+    st.reserve(2 * N + 1);
+    st.emplace_back();
+    std::uint32_t last = 0;
+    for (size_t k = 0; k < N; ++k) {
+        const int c = base_code(seq[k]);
+        const std::uint32_t cur = static_cast<std::uint32_t>(st.size());
+        st.emplace_back();
+        st[cur].len = st[last].len + 1;
+        st[cur].first = static_cast<std::uint32_t>(k + 1);
+        std::uint32_t p = last;
+        bool top = false;
+        while (st[p].next[c] == 0) {
+            st[p].next[c] = cur;
+            if (p == 0) {
+                top = true;
+                break;
+            }
+            p = st[p].link;
+        }
+        if (!top) {
+            const std::uint32_t q = st[p].next[c];
+            if (st[p].len + 1 == st[q].len) {
+                st[cur].link = q;
+            } else {
+                const std::uint32_t clone = static_cast<std::uint32_t>(st.size());
+                st.push_back(st[q]);
+                st[clone].len = st[p].len + 1;
+                st[clone].first = kNoEnd;
+                while (st[p].next[c] == q) {
+                    st[p].next[c] = clone;
+                    if (p == 0) break;
+                    p = st[p].link;
+                }
+                st[q].link = clone;
+                st[cur].link = clone;
+            }
+        }
+        last = cur;
+    }
+
+    // The end positions of a state are its own (if any) and those of its
+    // children in the link tree, which are longer: merge the two smallest
+    // upwards in decreasing length.
+    std::vector<std::uint32_t> count(N + 2, 0);
+    for (const AutomatonState& s : st) ++count[s.len + 1];
+    for (size_t l = 1; l < count.size(); ++l) count[l] += count[l - 1];
+    std::vector<std::uint32_t> order(st.size());
+    for (std::uint32_t s = 0; s < st.size(); ++s) order[count[st[s].len]++] = s;
+    for (size_t k = order.size(); k-- > 1;) {
+        const AutomatonState& s = st[order[k]];
+        AutomatonState& p = st[s.link];
+        for (const std::uint32_t e : {s.first, s.second}) {
+            if (e < p.first) {
+                p.second = p.first;
+                p.first = e;
+            } else if (e < p.second) {
+                p.second = e;
+            }
+        }
+    }
+    return st;
+}
+
+// once[i] / twice[i] = longest w <= max_len such that seq[i-w, i) occurs
+// once / twice ending at or before i - w.  Both grow by at most one per
+// base, so each walk keeps the state of seq[i-w, i) and otherwise only moves
+// down the suffix links, amortised O(N).
+void longest_earlier(const std::vector<AutomatonState>& st, const std::string& seq, int max_len,
+                     std::vector<std::uint16_t>& once, std::vector<std::uint16_t>* twice) {
+    struct Walk {
+        std::uint32_t s = 0;
+        long long l = 0;
+    };
+    auto step = [&](Walk& w, int c, long long i, bool second) {
+        w.s = st[w.s].next[c];
+        if (++w.l > max_len) {
+            w.l = max_len;
+            while (st[st[w.s].link].len >= w.l) w.s = st[w.s].link;
+        }
+        while (w.s != 0) {
+            const AutomatonState& s = st[w.s];
+            const long long best = std::min<long long>(w.l, i - static_cast<long long>(second ? s.second : s.first));
+            if (best > static_cast<long long>(st[s.link].len)) {
+                w.l = best;
+                return;
+            }
+            w.s = s.link;
+            w.l = st[w.s].len;
+        }
+        w.l = 0;
+    };
+    const long long N = static_cast<long long>(seq.size());
+    Walk a, b;
+    for (long long i = 1; i <= N; ++i) {
+        const int c = base_code(seq[static_cast<size_t>(i - 1)]);
+        step(a, c, i, false);
+        once[static_cast<size_t>(i)] = static_cast<std::uint16_t>(a.l);
+        if (twice) {
+            step(b, c, i, true);
+            (*twice)[static_cast<size_t>(i)] = static_cast<std::uint16_t>(b.l);
+        }
+    }
+}
+
+} // namespace
+
+// --- SELF REUSE ---
+
+void add_self_reuse(const std::string& seq, int max_len, int min_len, std::vector<std::uint16_t>& end_len,
+                    std::vector<std::uint16_t>* multi_len) {
+    if (seq.empty() || max_len < 1) return;
+    const size_t N = seq.size();
+    std::vector<std::uint16_t> once(N + 1, 0), twice;
+    if (multi_len) twice.assign(N + 1, 0);
+    longest_earlier(build_automaton(seq), seq, max_len, once, multi_len ? &twice : nullptr);
+    if (multi_len) {
+        for (size_t i = 1; i <= N; ++i) {
+            const std::uint16_t across = std::min(once[i], end_len[i]);
+            (*multi_len)[i] = std::max({(*multi_len)[i], twice[i], across});
+        }
+    }
+    for (size_t i = 1; i <= N; ++i) {
+        if (once[i] >= min_len && once[i] > end_len[i]) end_len[i] = once[i];
+    }
+}
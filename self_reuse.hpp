@@ -0,0 +1,24 @@
+#pragma once
+// Reuse from the target itself.
+//
+// A block whose sequence already occurs earlier in the record (a segmental
+// duplication, a repeated operon) can be amplified from the part built
+// before it instead of being synthesised again.  The copy has to end before
+// the block starts, so the parts a block is amplified from never depend on
+// the block.  One suffix automaton over the record answers, for every end
+// position, the longest such block: each state keeps its first and second
+// end position, and since the answer grows by at most one per base, one
+// amortised left-to-right walk over the automaton finds all of them in O(N).
+// The automaton costs about 32 bytes per state (at most 2N states).
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// For every i in [1, N] with a block seq[i-w, i), w <= max_len, that occurs
+// entirely within seq[0, i-w): raises end_len[i] to the longest such w (if it
+// is at least min_len).  With multi_len, also raises multi_len[i] to the
+// longest w that occurs twice there, or there and in the sources (judged from
+// end_len as passed in).  seq is ACGT; both arrays have N+1 entries.
+void add_self_reuse(const std::string& seq, int max_len, int min_len, std::vector<std::uint16_t>& end_len,
+                    std::vector<std::uint16_t>* multi_len);
@@ -0,0 +1,108 @@
+#include "synth_complexity.hpp"
+
+#include <algorithm>
+
+// --- RUN TABLES ---
+
+SynthComplexity::SynthComplexity(const std::string& seq, const SynthRules& rules) : seq_(seq), rules_(rules) {
+    const size_t N = seq.size();
+    gc_.assign(N + 1, 0);
+    homopolymer_.assign(N, 0);
+    repeat_.assign(N, 0);
+    for (size_t k = 0; k < N; ++k) {
+        gc_[k + 1] = gc_[k] + ((seq[k] == 'G' || seq[k] == 'C') ? 1u : 0u);
+    }
+
+    // One pass from the right.  matches[p] counts the positions m' >= m with
+    // seq[m'] == seq[m' + p] in an unbroken run; a run of at least p of them
+    // is a tandem repeat of period p spanning matches[p] + p bases.
+    const int max_period = std::max(1, rules.max_period);
+    std::vector<std::uint32_t> matches(static_cast<size_t>(max_period) + 1, 0);
+    auto cap = [](std::uint32_t x) { return static_cast<std::uint16_t>(std::min<std::uint32_t>(x, 65535u)); };
+    for (size_t m = N; m-- > 0;) {
+        homopolymer_[m] = (m + 1 < N && seq[m] == seq[m + 1]) ? cap(homopolymer_[m + 1] + 1u) : 1;
+        std::uint32_t longest = 0;
+        for (int p = 2; p <= max_period; ++p) {
+            std::uint32_t& run = matches[static_cast<size_t>(p)];
+            run = (m + static_cast<size_t>(p) < N && seq[m] == seq[m + static_cast<size_t>(p)]) ? run + 1 : 0;
+            if (run >= static_cast<std::uint32_t>(p)) longest = std::max(longest, run + static_cast<std::uint32_t>(p));
+        }
+        repeat_[m] = cap(longest);
+    }
+    for (size_t m = 0; m < N; ++m) {
+        if (homopolymer_[m] > rules.max_homopolymer || repeat_[m] > rules.max_repeat) hot_.push_back(m);
+    }
+}
+
+// --- PENALTIES ---
+
+double SynthComplexity::score(size_t w, std::uint32_t gc, int homopolymer, int repeat) const {
+    double off = 0.0;
+    if (w >= static_cast<size_t>(rules_.gc_min_len)) {
+        const double percent = 100.0 * static_cast<double>(gc) / static_cast<double>(w);
+        off += std::max({0.0, rules_.gc_min - percent, percent - rules_.gc_max});
+    }
+    off += std::max(0, homopolymer - rules_.max_homopolymer);
+    off += std::max(0, repeat - rules_.max_repeat);
+    return rules_.penalty * off;
+}
+
+namespace {
+
+// percent_per_base[w] = 100 / w, so the GC pass multiplies instead of dividing.
+const std::vector<double>& percent_per_base() {
+    static const std::vector<double> table = [] {
+        std::vector<double> t(65536, 0.0);
+        for (size_t w = 1; w < t.size(); ++w) t[w] = 100.0 / static_cast<double>(w);
+        return t;
+    }();
+    return table;
+}
+
+} // namespace
+
+void SynthComplexity::penalties_ending_at(size_t i, int max_w, double* out) const {
+    const double* per_base = percent_per_base().data();
+    const std::uint32_t* gc_end = gc_.data() + i;
+    const int gc_from = std::max(1, rules_.gc_min_len);
+    // Lengths [w_from, w_to) with run excess `excess`.
+    auto fill = [&](int w_from, int w_to, int excess) {
+        const double runs = static_cast<double>(excess);
+        int w = w_from;
+        for (; w < std::min(w_to, gc_from); ++w) out[w] = rules_.penalty * runs;
+        for (; w < w_to; ++w) {
+            const double percent = static_cast<double>(*gc_end - gc_end[-w]) * per_base[w];
+            const double off = std::max(0.0, std::max(rules_.gc_min - percent, percent - rules_.gc_max));
+            out[w] = rules_.penalty * (off + runs);
+        }
+    };
+
+    out[0] = 0.0;
+    int homopolymer = 0;
+    int repeat = 0;
+    int w = 1;
+    // Hot positions m in [i - max_w, i), nearest first: each raises the run
+    // maxima for every length w >= i - m.
+    auto it = std::lower_bound(hot_.begin(), hot_.end(), i);
+    while (it != hot_.begin()) {
+        const size_t m = *--it;
+        const int reach = static_cast<int>(i - m);
+        if (reach > max_w) break;
+        fill(w, reach, std::max(0, homopolymer - rules_.max_homopolymer) + std::max(0, repeat - rules_.max_repeat));
+        w = reach;
+        homopolymer = std::max(homopolymer, std::min<int>(homopolymer_[m], reach));
+        repeat = std::max(repeat, std::min<int>(repeat_[m], reach));
+    }
+    fill(w, max_w + 1, std::max(0, homopolymer - rules_.max_homopolymer) + std::max(0, repeat - rules_.max_repeat));
+}
+
+double SynthComplexity::penalty(size_t j, size_t i) const {
+    int homopolymer = 0;
+    int repeat = 0;
+    for (size_t m = j; m < i; ++m) {
+        const int room = static_cast<int>(i - m);
+        homopolymer = std::max(homopolymer, std::min<int>(homopolymer_[m], room));
+        repeat = std::max(repeat, std::min<int>(repeat_[m], room));
+    }
+    return score(i - j, gc_[i] - gc_[j], homopolymer, repeat);
+}
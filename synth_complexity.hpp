@@ -0,0 +1,54 @@
+#pragma once
+// Sequence-complexity penalties for synthesised blocks.
+//
+// Vendors reject or upcharge fragments with extreme GC content, long
+// homopolymers or internal tandem repeats.  Per record we keep the GC prefix
+// sum and, for every position m, the longest homopolymer and the longest
+// tandem repeat (period 2..max_period, at least two copies) starting at m.
+// The longest run inside seq[j, i) is the maximum over m in [j, i) of that
+// forward length clipped to i - m.  Only the few positions whose runs exceed
+// the limits ("hot" positions) can contribute, so for all blocks ending at i
+// the run penalty is a step function of the length, built from the hot
+// positions within reach, and the GC term is one flat pass over the lengths.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SynthRules {
+    double penalty = 0.0;        // cost per unit outside the limits; 0 disables the rules
+    double gc_min = 25.0;        // acceptable GC content of a block, percent
+    double gc_max = 75.0;
+    int gc_min_len = 50;         // shorter blocks (oligos) are not judged on GC
+    int max_homopolymer = 8;     // longest acceptable single-base run
+    int max_repeat = 16;         // longest acceptable tandem repeat
+    int max_period = 6;          // repeat units of 2..max_period bases
+
+    bool enabled() const { return penalty > 0.0; }
+    // Below two copies of the longest unit, a repeat clipped by the block
+    // edge may no longer be a repeat; the run tables are exact above it.
+    int min_repeat_limit() const { return 2 * max_period - 1; }
+};
+
+class SynthComplexity {
+public:
+    // Keeps a reference to seq, which must outlive this object.
+    SynthComplexity(const std::string& seq, const SynthRules& rules);
+
+    // out[w] = penalty of synthesising seq[i - w, i), for w = 1..max_w
+    // (out[0] = 0).  O(max_w); out must hold max_w + 1 entries.
+    void penalties_ending_at(size_t i, int max_w, double* out) const;
+    // Penalty of one block, O(i - j).
+    double penalty(size_t j, size_t i) const;
+
+private:
+    double score(size_t w, std::uint32_t gc, int homopolymer, int repeat) const;
+
+    const std::string& seq_;
+    SynthRules rules_;
+    std::vector<std::uint32_t> gc_;           // gc_[k]: G/C among seq[0, k)
+    std::vector<std::uint16_t> homopolymer_;  // longest single-base run starting at m
+    std::vector<std::uint16_t> repeat_;       // longest tandem repeat starting at m, 0 if none
+    std::vector<size_t> hot_;                 // ascending m whose run exceeds a limit
+};
@@ -0,0 +1,174 @@
+// Regression tests for assemble_levels: the joint solver against a brute force
+// over every assignment of levels to the cuts, and the one-level-at-a-time
+// fallback (forced with a unit cap of zero) against a brute force of each
+// level given the cuts kept by the level below.
+
+#include "../assembly_levels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+bool close(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+struct Record {
+    std::vector<std::uint64_t> cuts;
+    std::vector<double> prefix;
+    double leaf_join = 0.0;
+    std::vector<AssemblyLevel> levels;
+
+    std::string describe() const {
+        std::ostringstream out;
+        out << "cuts";
+        for (std::uint64_t c : cuts) out << ' ' << c;
+        out << ", leaf join " << leaf_join << ", levels";
+        for (const AssemblyLevel& level : levels) out << ' ' << level.max_len << ':' << level.join;
+        return out.str();
+    }
+};
+
+// Every levels[m] unit, delimited by the cuts at level m + 1 or above, fits.
+bool feasible(const Record& r, const std::vector<std::uint8_t>& cut_level) {
+    const size_t n = r.cuts.size() - 1;
+    for (size_t m = 0; m < r.levels.size(); ++m) {
+        size_t start = 0;
+        for (size_t k = 1; k <= n; ++k) {
+            if (k < n && cut_level[k] <= m) continue;
+            if (r.cuts[k] - r.cuts[start] > static_cast<std::uint64_t>(r.levels[m].max_len)) return false;
+            start = k;
+        }
+    }
+    return true;
+}
+
+// The leaf plan with each junction at level v > 0 paying levels[v - 1].join.
+double plan_cost(const Record& r, const std::vector<std::uint8_t>& cut_level) {
+    double cost = r.prefix.back();
+    for (size_t k = 1; k + 1 < r.cuts.size(); ++k) {
+        if (cut_level[k] > 0) cost += r.levels[cut_level[k] - 1].join - r.leaf_join;
+    }
+    return cost;
+}
+
+// Cheapest feasible assignment of a level in [0, L] to every inner cut.
+double brute_force(const Record& r) {
+    const size_t inner = r.cuts.size() - 2;
+    const size_t base = r.levels.size() + 1;
+    std::vector<std::uint8_t> cut_level(r.cuts.size(), 0);
+    double best = std::numeric_limits<double>::infinity();
+    for (;;) {
+        if (feasible(r, cut_level)) best = std::min(best, plan_cost(r, cut_level));
+        size_t k = 1;
+        while (k <= inner && ++cut_level[k] == base) cut_level[k++] = 0;
+        if (k > inner) return best;
+    }
+}
+
+// Each level of the fallback, given the cuts the level below kept, keeps the
+// fitting subset of them with the cheapest joins: compared by brute force.
+void check_per_level(const Record& r, const std::vector<std::uint8_t>& cut_level, const std::string& tag) {
+    double lower_join = r.leaf_join;
+    for (size_t m = 0; m < r.levels.size(); ++m) {
+        std::vector<size_t> below;   // cuts kept by the level below, ends included
+        for (size_t k = 0; k < r.cuts.size(); ++k) {
+            if (k == 0 || k + 1 == r.cuts.size() || cut_level[k] >= m) below.push_back(k);
+        }
+        const double delta = r.levels[m].join - lower_join;
+        const std::uint64_t max_len = static_cast<std::uint64_t>(r.levels[m].max_len);
+        const size_t inner = below.size() - 2;
+        double best = std::numeric_limits<double>::infinity();
+        for (std::uint32_t mask = 0; mask < (std::uint32_t(1) << inner); ++mask) {
+            size_t start = 0, kept = 0;
+            bool fits = true;
+            for (size_t t = 1; t < below.size() && fits; ++t) {
+                if (t + 1 < below.size() && !(mask >> (t - 1) & 1)) continue;
+                fits = r.cuts[below[t]] - r.cuts[below[start]] <= max_len;
+                start = t;
+                kept += t + 1 < below.size();
+            }
+            if (fits) best = std::min(best, static_cast<double>(kept) * delta);
+        }
+        size_t kept = 0;
+        for (size_t k = 1; k + 1 < r.cuts.size(); ++k) kept += cut_level[k] >= m + 1;
+        check(close(static_cast<double>(kept) * delta, best),
+              "fallback level " + std::to_string(m + 1) + " keeps the cheapest cuts (" + tag + ")");
+        lower_join = r.levels[m].join;
+    }
+}
+
+Record random_record(std::mt19937& rng) {
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+    auto real = [&](double lo, double hi) { return std::uniform_real_distribution<double>(lo, hi)(rng); };
+    Record r;
+    r.leaf_join = real(0.0, 3.0);
+    const int blocks = uniform(1, 9);
+    int longest = 0;
+    r.cuts.push_back(0);
+    r.prefix.push_back(0.0);
+    for (int b = 0; b < blocks; ++b) {
+        const int len = uniform(1, 6);
+        longest = std::max(longest, len);
+        r.cuts.push_back(r.cuts.back() + static_cast<std::uint64_t>(len));
+        r.prefix.push_back(r.prefix.back() + real(0.0, 10.0) + (b > 0 ? r.leaf_join : 0.0));
+    }
+    // Joins below the leaf join too, which the joint solver tables in full.
+    long long max_len = longest + uniform(0, 4);
+    for (int l = uniform(1, 3); l > 0; --l) {
+        r.levels.push_back({max_len, real(0.0, 6.0)});
+        max_len += uniform(1, 12);
+    }
+    return r;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240611);
+    // The fallback warns on every call; keep the test output to the verdict.
+    std::ostringstream quiet;
+    std::streambuf* saved = std::cerr.rdbuf();
+    for (int trial = 0; trial < 2000; ++trial) {
+        const Record r = random_record(rng);
+        const std::string tag = r.describe();
+        const double best = brute_force(r);
+
+        std::vector<std::uint8_t> joint;
+        const double cost = assemble_levels(r.cuts, r.prefix, r.leaf_join, r.levels, joint);
+        check(feasible(r, joint), "joint plan fits its levels (" + tag + ")");
+        check(close(cost, plan_cost(r, joint)), "joint cost matches its plan (" + tag + ")");
+        check(close(cost, best), "joint cost is the brute-force optimum (" + tag + ")");
+
+        std::vector<std::uint8_t> split;
+        std::cerr.rdbuf(quiet.rdbuf());
+        const double fallback = assemble_levels(r.cuts, r.prefix, r.leaf_join, r.levels, split, 0);
+        std::cerr.rdbuf(saved);
+        quiet.str("");
+        check(feasible(r, split), "fallback plan fits its levels (" + tag + ")");
+        check(close(fallback, plan_cost(r, split)), "fallback cost matches its plan (" + tag + ")");
+        check(fallback >= best - 1e-9 * std::max(1.0, best), "fallback is no cheaper than the optimum (" + tag + ")");
+        if (r.levels.size() == 1) check(close(fallback, best), "one level is exact either way (" + tag + ")");
+        check_per_level(r, split, tag);
+    }
+    if (failures) return 1;
+    std::cout << "test_assembly_levels: OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Regression tests for open_byte_source's BGZF reader.  BGZF files are written
+// here with zlib directly so the test does not need bgzip.
+
+#include "../byte_source.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+void put_le(std::string& s, std::uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) s.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+// One BGZF member holding data (empty data gives the standard EOF block).
+std::string bgzf_block(const std::string& data) {
+    z_stream zs{};
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    std::vector<unsigned char> comp(deflateBound(&zs, data.size()) + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = comp.data();
+    zs.avail_out = static_cast<uInt>(comp.size());
+    deflate(&zs, Z_FINISH);
+    const size_t clen = zs.total_out;
+    deflateEnd(&zs);
+
+    std::string b = {'\x1f', '\x8b', '\x08', '\x04', 0, 0, 0, 0, 0, '\xff'};
+    put_le(b, 6, 2);                       // XLEN
+    b += "BC";
+    put_le(b, 2, 2);
+    put_le(b, static_cast<std::uint32_t>(12 + 6 + clen + 8 - 1), 2);   // BSIZE - 1
+    b.append(reinterpret_cast<const char*>(comp.data()), clen);
+    put_le(b, static_cast<std::uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(data.size()))), 4);
+    put_le(b, static_cast<std::uint32_t>(data.size()), 4);
+    return b;
+}
+
+// Writes `blocks` data blocks plus the EOF block and reads the file back.
+void round_trip(size_t blocks) {
+    const std::string path = "/tmp/test_byte_source_" + std::to_string(blocks) + ".fa.gz";
+    std::string expect;
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (size_t i = 0; i < blocks; ++i) {
+            const std::string data = ">r" + std::to_string(i) + "\nACGTACGTNNACGT\n";
+            expect += data;
+            out << bgzf_block(data);
+        }
+        out << bgzf_block("");
+    }
+    for (int threads : {1, 4}) {
+        auto src = open_byte_source(path, threads);
+        const std::string tag = std::to_string(blocks) + " blocks, " + std::to_string(threads) + " threads";
+        check(src && std::string(src->kind()) == "bgzf", "detected as BGZF (" + tag + ")");
+        if (!src) continue;
+        std::string got;
+        char buf[4096];
+        for (size_t n; (n = src->read(buf, sizeof(buf))) > 0;) got.append(buf, n);
+        check(!src->failed(), "no failure (" + tag + ")");
+        check(got == expect, "content matches (" + tag + ")");
+    }
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    // 64 and 128 data blocks put the EOF block at the start of its own batch.
+    for (size_t blocks : {1, 63, 64, 65, 128}) round_trip(blocks);
+    if (failures) return 1;
+    std::cout << "test_byte_source: OK" << std::endl;
+    return 0;
+}
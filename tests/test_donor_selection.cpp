@@ -0,0 +1,220 @@
+// Regression tests for the incremental DP behind donor selection: DpSession
+// against a full solve of every candidate profile, and the greedy and
+// branch-and-bound subsets against an enumeration of every donor subset of
+// small random panels.
+
+#include "../donor_selection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+bool close(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+std::string random_seq(std::mt19937& rng, int n) {
+    std::string seq(static_cast<size_t>(n), 'A');
+    for (char& c : seq) c = "ACGT"[rng() % 4];
+    return seq;
+}
+
+// Float or integer costs, with or without overlap, motifs and reusable synthesis.
+CostModel random_costs(std::mt19937& rng, int W) {
+    CostModel costs;
+    costs.pcr = 5 + rng() % 20;
+    costs.join = rng() % 4;
+    costs.synth_linear = 0.3 + (rng() % 10) / 10.0;
+    if (rng() % 2) costs.scale = 100;
+    if (rng() % 3 == 0) costs.overlap = static_cast<int>(rng() % static_cast<unsigned>(W / 2));
+    if (rng() % 3 == 0) costs.forbidden_motifs = {"GAATTC", "GC"};
+    if (rng() % 3 == 0) costs.synth_reusable = true;
+    return costs;
+}
+
+// Raises p over `count` random stretches, returning the positions raised.
+std::vector<long long> raise_stretches(std::mt19937& rng, ReuseProfile& p, int count) {
+    const long long N = static_cast<long long>(p.end_len.size()) - 1;
+    std::vector<long long> changed;
+    for (int c = 0; c < count; ++c) {
+        const long long at = 1 + static_cast<long long>(rng() % static_cast<unsigned long long>(N));
+        const long long len = 1 + static_cast<long long>(rng() % 200);
+        for (long long i = at; i < std::min(N + 1, at + len); ++i) {
+            const std::uint16_t v = static_cast<std::uint16_t>(std::min<long long>(i, rng() % static_cast<unsigned>(p.W + 5)));
+            bool raised = false;
+            if (v > p.end_len[i]) {
+                p.end_len[i] = v;
+                raised = true;
+            }
+            if (!p.tier_len.empty()) {
+                const std::uint16_t cheap = (rng() % 2) ? v : 0;
+                raised = raised || cheap > p.tier_len[0][i] || p.end_len[i] > p.tier_len[1][i];
+                p.tier_len[0][i] = std::max(p.tier_len[0][i], cheap);
+                p.tier_len[1][i] = p.end_len[i];
+            }
+            if (raised) changed.push_back(i);
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+// DpSession::evaluate on the changed positions (or a superset of them) and
+// cost after adopt, against solve_dp_for_chromosome on the whole profile.
+void test_session(std::mt19937& rng) {
+    for (int trial = 0; trial < 300; ++trial) {
+        const int W = 4 + static_cast<int>(rng() % 30);
+        const int N = 1 + static_cast<int>(rng() % 3000);
+        const std::string seq = random_seq(rng, N);
+        const CostModel costs = random_costs(rng, W);
+        ReuseProfile ref;
+        ref.W = W;
+        ref.end_len.assign(static_cast<size_t>(N) + 1, 0);
+        if (rng() % 2) {
+            ref.tier_pcr = {costs.pcr - 2, costs.pcr};
+            ref.tier_len.assign(2, std::vector<std::uint16_t>(static_cast<size_t>(N) + 1, 0));
+        }
+        raise_stretches(rng, ref, static_cast<int>(rng() % 10));
+        const std::string tag = "N " + std::to_string(N) + ", W " + std::to_string(W) +
+                                (costs.scale > 0 ? ", integer" : ", float") + ", trial " + std::to_string(trial);
+
+        DpSession session(seq, ref, costs);
+        check(close(session.cost(), solve_dp_for_chromosome(seq, ref, costs).cost), "session cost (" + tag + ")");
+        for (int c = 0; c < 5; ++c) {
+            ReuseProfile candidate = ref;
+            std::vector<long long> changed = raise_stretches(rng, candidate, 1 + static_cast<int>(rng() % 4));
+            if (rng() % 3 == 0) {
+                for (int extra = 0; extra < 20; ++extra) changed.push_back(1 + static_cast<long long>(rng() % static_cast<unsigned>(N)));
+                std::sort(changed.begin(), changed.end());
+                changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+            }
+            const double want = solve_dp_for_chromosome(seq, candidate, costs).cost;
+            check(close(session.evaluate(candidate, changed), want), "evaluate matches a full solve (" + tag + ")");
+            if (c == 2) {
+                session.adopt(candidate);
+                ref = candidate;
+                check(close(session.cost(), want), "cost after adopt (" + tag + ")");
+            }
+        }
+    }
+}
+
+// The profile of record r with the given donors, built directly.
+ReuseProfile subset_profile(const DonorEnds& ends, size_t r, int W, const std::vector<double>& pcr, unsigned mask) {
+    ReuseProfile p;
+    p.W = W;
+    p.end_len.assign(ends[0][r].size(), 0);
+    p.tier_pcr = pcr;
+    std::sort(p.tier_pcr.begin(), p.tier_pcr.end());
+    p.tier_pcr.erase(std::unique(p.tier_pcr.begin(), p.tier_pcr.end()), p.tier_pcr.end());
+    p.tier_len.assign(p.tier_pcr.size(), std::vector<std::uint16_t>(p.end_len.size(), 0));
+    for (size_t d = 0; d < ends.size(); ++d) {
+        if (!(mask >> d & 1)) continue;
+        for (size_t i = 0; i < p.end_len.size(); ++i) {
+            const std::uint16_t v = ends[d][r][i];
+            p.end_len[i] = std::max(p.end_len[i], v);
+            for (size_t t = 0; t < p.tier_pcr.size(); ++t) {
+                if (pcr[d] <= p.tier_pcr[t]) p.tier_len[t][i] = std::max(p.tier_len[t][i], v);
+            }
+        }
+    }
+    return p;
+}
+
+// Greedy and exact curves on random panels of up to six donors, against the
+// cost of every subset.
+void test_selection(std::mt19937& rng) {
+    for (int trial = 0; trial < 150; ++trial) {
+        const int W = 4 + static_cast<int>(rng() % 20);
+        const size_t R = 1 + rng() % 3;
+        const size_t D = 1 + rng() % 6;
+        std::vector<std::string> seqs;
+        for (size_t r = 0; r < R; ++r) seqs.push_back(random_seq(rng, 1 + static_cast<int>(rng() % 300)));
+        CostModel costs = random_costs(rng, W);
+        costs.synth_reusable = true;
+        if (rng() % 2) {
+            for (size_t d = 0; d < D; ++d) costs.source_pcr.push_back(costs.pcr - static_cast<double>(rng() % 3));
+        }
+        // Every donor holds matches over a few stretches of every record.
+        DonorEnds ends(D);
+        for (size_t d = 0; d < D; ++d) {
+            for (size_t r = 0; r < R; ++r) {
+                ReuseProfile p;
+                p.W = W;
+                p.end_len.assign(seqs[r].size() + 1, 0);
+                raise_stretches(rng, p, static_cast<int>(rng() % 4));
+                ends[d].push_back(p.end_len);
+            }
+        }
+        const std::vector<double> pcr = costs.source_pcr.empty() ? std::vector<double>(D, costs.pcr) : costs.source_pcr;
+        std::vector<double> subset_cost(size_t(1) << D, 0.0);
+        for (unsigned mask = 0; mask < (1u << D); ++mask) {
+            for (size_t r = 0; r < R; ++r) {
+                const ReuseProfile p = subset_profile(ends, r, W, costs.source_pcr.empty() ? std::vector<double>() : pcr, mask);
+                subset_cost[mask] += solve_dp_for_chromosome(seqs[r], p, costs).cost;
+            }
+        }
+        auto mask_of = [](const std::vector<size_t>& donors) {
+            unsigned mask = 0;
+            for (const size_t d : donors) mask |= 1u << d;
+            return mask;
+        };
+        const std::string tag = std::to_string(D) + " donors, " + std::to_string(R) + " records, trial " + std::to_string(trial);
+
+        std::vector<DonorSubset> greedy, exact;
+        donor_subset_curve(seqs, ends, W, costs, -1, false, greedy);
+        donor_subset_curve(seqs, ends, W, costs, -1, true, exact);
+        check(greedy.size() == D + 1 && exact.size() == D + 1, "a subset for every k (" + tag + ")");
+        if (greedy.size() != D + 1 || exact.size() != D + 1) continue;
+        for (size_t k = 0; k <= D; ++k) {
+            const std::string at = "k = " + std::to_string(k) + ", " + tag;
+            check(greedy[k].donors.size() == k && exact[k].donors.size() == k, "k donors (" + at + ")");
+            const unsigned g = mask_of(greedy[k].donors);
+            check(close(greedy[k].cost, subset_cost[g]), "greedy cost is its subset's (" + at + ")");
+            if (k > 0) {
+                // The cheapest single addition to the previous greedy subset.
+                const unsigned before = mask_of(greedy[k - 1].donors);
+                check((g & before) == before, "greedy subsets nest (" + at + ")");
+                double step = std::numeric_limits<double>::infinity();
+                for (size_t d = 0; d < D; ++d) {
+                    if (!(before >> d & 1)) step = std::min(step, subset_cost[before | (1u << d)]);
+                }
+                check(close(greedy[k].cost, step), "greedy adds the best donor (" + at + ")");
+            }
+            double best = std::numeric_limits<double>::infinity();
+            for (unsigned mask = 0; mask < (1u << D); ++mask) {
+                if (static_cast<size_t>(__builtin_popcount(mask)) == k) best = std::min(best, subset_cost[mask]);
+            }
+            check(close(exact[k].cost, subset_cost[mask_of(exact[k].donors)]), "exact cost is its subset's (" + at + ")");
+            check(close(exact[k].cost, best), "exact cost is the enumerated optimum (" + at + ")");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240612);
+    test_session(rng);
+    test_selection(rng);
+    if (failures) return 1;
+    std::cout << "test_donor_selection: OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Regression tests for circular records with forbidden motifs: a circle with
+// no allowed cut has no plan (planned is false, not an unreachable cost), and
+// on circles that have a plan the DP is never beaten by the greedy planners.
+
+#include "../planner_core.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+PlannerStats plan(const std::string& planner, const std::string& seq, int W, const CostModel& costs) {
+    ReuseProfile reuse;
+    reuse.W = W;
+    reuse.end_len.assign(seq.size() + 2 * static_cast<size_t>(circular_margin(costs, W)) + 1, 0);
+    reuse.start_len = reuse.end_len;
+    return make_planner(planner)->plan(seq, reuse, costs, nullptr);
+}
+
+CostModel circular_costs(int scale, int overlap) {
+    CostModel costs;
+    costs.pcr = 5;
+    costs.join = 1;
+    costs.synth_linear = 0.5;
+    costs.circular = true;
+    costs.scale = scale;
+    costs.overlap = overlap;
+    costs.forbidden_motifs = {"AAAAAA"};
+    return costs;
+}
+
+} // namespace
+
+int main() {
+    // Every boundary of a homopolymer circle lies inside the motif (or its
+    // reverse complement); longer ones still get a cut reopened within the
+    // extension (forbidden_boundaries).
+    for (const int scale : {0, 100}) {
+        const std::string type = scale > 0 ? "integer" : "float";
+        for (const std::string seq : {"A", "AAA", "TTTT"}) {
+            const PlannerStats stats = plan("dp", seq, 20, circular_costs(scale, 0));
+            check(!stats.planned, "no plan for a blocked circle of " + std::to_string(seq.size()) + " (" + type + ")");
+        }
+        for (const size_t n : {19, 41}) {
+            const PlannerStats stats = plan("dp", std::string(n, 'A'), 20, circular_costs(scale, 0));
+            check(stats.planned && std::isfinite(stats.cost) && stats.cost < 1e6,
+                  "a plan for a blocked circle of " + std::to_string(n) + " (" + type + ")");
+        }
+    }
+
+    std::mt19937 rng(20240615);
+    for (int trial = 0; trial < 1500; ++trial) {
+        const int W = 8 + static_cast<int>(rng() % 30);
+        std::string seq(rng() % 3 ? W + rng() % 60 : 1 + rng() % W, 'A');
+        for (size_t k = rng() % (seq.size() + 1); k < seq.size(); ++k) seq[k] = "ACGT"[rng() % 4];
+        const CostModel costs = circular_costs(rng() % 2 ? 100 : 0, rng() % 3 == 0 ? static_cast<int>(rng() % (W / 2)) : 0);
+        const std::string tag = seq + ", W " + std::to_string(W) + ", trial " + std::to_string(trial);
+        const PlannerStats dp = plan("dp", seq, W, costs);
+        if (!dp.planned) {
+            check(seq.size() < static_cast<size_t>(W), "no plan only for a circle shorter than W (" + tag + ")");
+            continue;
+        }
+        check(std::isfinite(dp.cost) && dp.cost < 1e6, "a finite cost (" + tag + ")");
+        for (const char* other : {"greedy", "maxblock"}) {
+            const PlannerStats heuristic = plan(other, seq, W, costs);
+            check(!heuristic.planned || dp.cost <= heuristic.cost + 1e-9 * std::max(1.0, heuristic.cost),
+                  std::string("no cheaper ") + other + " plan (" + tag + ")");
+        }
+    }
+    if (failures) return 1;
+    std::cout << "test_dp_circular: OK" << std::endl;
+    return 0;
+}
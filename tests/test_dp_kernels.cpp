@@ -0,0 +1,114 @@
+// Regression tests for min_plus_argmin: every overload against a plain loop
+// with the same evaluation order, on lengths around the 4-, 8- and 16-lane
+// widths, with ties (the largest index must win) and unreachable entries.
+// The kernel is picked once per process, so without PLANNER_SIMD the test
+// re-runs itself under each setting; a CPU without a kernel falls back to
+// the next one, which dp_kernel_name reports.
+
+#include "../dp_kernels.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+template <typename T>
+MinArg<T> reference(const T* a, const T* b, const T* c, size_t n) {
+    MinArg<T> best{std::numeric_limits<T>::max(), -1};
+    for (size_t k = 0; k < n; ++k) {
+        const T v = c ? a[k] + b[k] + *c : a[k] + b[k];
+        if (v <= best.value) best = {v, static_cast<long long>(k)};
+    }
+    return best;
+}
+
+// What the DP stores for a position it cannot reach (DpCosts::unreachable).
+template <typename T>
+T unreachable() {
+    if constexpr (std::is_floating_point<T>::value) {
+        return std::numeric_limits<T>::infinity();
+    } else {
+        return std::numeric_limits<T>::max() / 2;
+    }
+}
+
+// Values from a narrow range, so most minima are tied; some a[k] unreachable
+// (only a for integers, so sums stay in range), all of them in some rounds.
+template <typename T>
+void fill(std::mt19937& rng, std::vector<T>& a, std::vector<T>& b, int round) {
+    const int range = 1 + round % 4;
+    const int holes = round % 5;   // 0: none, 4: every entry
+    for (size_t k = 0; k < a.size(); ++k) {
+        a[k] = static_cast<T>(static_cast<int>(rng() % static_cast<unsigned>(range)) - 1);
+        b[k] = static_cast<T>(static_cast<int>(rng() % static_cast<unsigned>(range)));
+        if constexpr (std::is_floating_point<T>::value) {
+            a[k] += static_cast<T>(0.5);
+            if (holes > 0 && static_cast<int>(rng() % 4) < holes) b[k] = unreachable<T>();
+        }
+        if (holes > 0 && static_cast<int>(rng() % 4) < holes) a[k] = unreachable<T>();
+    }
+}
+
+template <typename T>
+void test_type(std::mt19937& rng, const std::string& type) {
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 40; ++n) lengths.push_back(n);
+    for (size_t n : {63, 64, 65, 127, 128, 129, 1000}) lengths.push_back(n);
+    for (const size_t n : lengths) {
+        for (int round = 0; round < 40; ++round) {
+            // One spare entry in front, to run from an unaligned start too.
+            std::vector<T> a(n + 1), b(n + 1);
+            fill(rng, a, b, round);
+            const size_t off = static_cast<size_t>(round % 2);
+            const size_t len = n;
+            const T c = static_cast<T>(round % 3);
+            const std::string tag = type + ", n " + std::to_string(len) + ", offset " + std::to_string(off) +
+                                    ", round " + std::to_string(round);
+
+            const MinArg<T> want_c = reference(a.data() + off, b.data() + off, &c, len);
+            const MinArg<T> got_c = min_plus_argmin(a.data() + off, b.data() + off, c, len);
+            check(got_c.value == want_c.value && got_c.index == want_c.index, "with c (" + tag + ")");
+
+            const MinArg<T> want = reference<T>(a.data() + off, b.data() + off, nullptr, len);
+            const MinArg<T> got = min_plus_argmin(a.data() + off, b.data() + off, len);
+            check(got.value == want.value && got.index == want.index, "without c (" + tag + ")");
+        }
+    }
+}
+
+int run_checks() {
+    std::mt19937 rng(20240613);
+    test_type<double>(rng, "double");
+    test_type<std::int32_t>(rng, "int32");
+    test_type<std::int64_t>(rng, "int64");
+    if (failures) return 1;
+    std::cout << "test_dp_kernels (" << dp_kernel_name() << "): OK" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int, char** argv) {
+    if (std::getenv("PLANNER_SIMD")) return run_checks();
+    int status = 0;
+    for (const char* simd : {"avx512", "avx2", "scalar"}) {
+        const std::string command = std::string("PLANNER_SIMD=") + simd + " '" + argv[0] + "'";
+        if (std::system(command.c_str()) != 0) status = 1;
+    }
+    return status;
+}
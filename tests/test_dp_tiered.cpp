@@ -0,0 +1,117 @@
+// Regression tests for the bracket-window DP (solve_dp_tiered): with a
+// step-function --synth-table it must return the scan's cost and, with
+// integer costs, the scan's blocks.  PLANNER_DP=scan switches the scan back
+// on for the comparison.
+
+#include "../planner_core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+bool close(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+bool same_blocks(const std::vector<PlanBlock>& a, const std::vector<PlanBlock>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t k = 0; k < a.size(); ++k) {
+        if (a[k].start != b[k].start || a[k].length != b[k].length || a[k].reuse != b[k].reuse) return false;
+    }
+    return true;
+}
+
+PlannerStats solve(const std::string& seq, const ReuseProfile& reuse, const CostModel& costs,
+                   std::vector<PlanBlock>& blocks, bool scan) {
+    if (scan) {
+        setenv("PLANNER_DP", "scan", 1);
+    } else {
+        unsetenv("PLANNER_DP");
+    }
+    blocks.clear();
+    return solve_dp_for_chromosome(seq, reuse, costs, &blocks);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240614);
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+    for (int trial = 0; trial < 600; ++trial) {
+        const int W = uniform(16, 200);
+        const int N = uniform(0, 3000);
+        std::string seq(static_cast<size_t>(N), 'A');
+        for (char& c : seq) c = "ACGT"[rng() % 4];
+
+        // A step-function price list with at most W / 16 brackets, so the
+        // bracket windows are used.
+        CostModel costs;
+        costs.pcr = uniform(5, 40);
+        costs.join = uniform(0, 1) ? uniform(1, 4) : 0;
+        if (uniform(0, 1)) costs.scale = 100;
+        costs.synth_table.assign(static_cast<size_t>(W) + 1, 0.0);
+        const int brackets = uniform(1, W / 16);
+        double price = uniform(1, 10);
+        int next_step = W / brackets;
+        for (int w = 1; w <= W; ++w) {
+            if (w > next_step) {
+                price += uniform(0, 30) + (costs.scale > 0 ? 0.0 : 0.25 * uniform(0, 3));
+                next_step += W / brackets;
+            }
+            costs.synth_table[static_cast<size_t>(w)] = price;
+        }
+        if (uniform(0, 2) == 0) costs.reuse_min = uniform(1, W / 2);
+        if (uniform(0, 2) == 0) costs.reuse_max = uniform(costs.reuse_min, W);
+        if (uniform(0, 2) == 0) costs.overlap = uniform(0, W / 4);
+        if (uniform(0, 2) == 0) costs.forbidden_motifs = {"GAATTC", "GC"};
+        if (uniform(0, 3) == 0) costs.primer.length = uniform(8, 12);
+
+        // Matches as the backward search reports them: end_len[i] is at most
+        // end_len[i - 1] + 1, so i - end_len[i] never decreases.
+        ReuseProfile reuse;
+        reuse.W = W;
+        reuse.end_len.assign(static_cast<size_t>(N) + 1, 0);
+        for (int s = uniform(0, 12); s > 0 && N > 0; --s) {
+            const long long at = uniform(1, N);
+            const long long len = uniform(1, 3 * W);
+            const long long head = uniform(0, W);
+            for (long long i = at; i <= std::min<long long>(N, at + len); ++i) {
+                std::uint16_t& e = reuse.end_len[static_cast<size_t>(i)];
+                e = std::max<std::uint16_t>(e, static_cast<std::uint16_t>(std::min<long long>(W, head + i - at)));
+            }
+        }
+        for (size_t i = 1; i < reuse.end_len.size(); ++i) {
+            reuse.end_len[i] = std::min<std::uint16_t>(reuse.end_len[i], static_cast<std::uint16_t>(
+                std::min<long long>(static_cast<long long>(i), reuse.end_len[i - 1] + 1)));
+        }
+
+        const std::string tag = "N " + std::to_string(N) + ", W " + std::to_string(W) + ", " +
+                                std::to_string(brackets) + " brackets" +
+                                (costs.scale > 0 ? ", integer" : ", float") + ", trial " + std::to_string(trial);
+        std::vector<PlanBlock> tiered, scan;
+        const PlannerStats got = solve(seq, reuse, costs, tiered, false);
+        const PlannerStats want = solve(seq, reuse, costs, scan, true);
+        check(close(got.cost, want.cost), "tiered cost matches the scan (" + tag + ")");
+        if (costs.scale > 0) check(same_blocks(tiered, scan), "tiered blocks match the scan (" + tag + ")");
+    }
+    unsetenv("PLANNER_DP");
+    if (failures) return 1;
+    std::cout << "test_dp_tiered: OK" << std::endl;
+    return 0;
+}